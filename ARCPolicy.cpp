@@ -0,0 +1,218 @@
+#include "ARCPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+ARCPolicy::ARCPolicy(Block* pool) : CachePolicy(pool), _capacity(0), _p(0)
+{
+	_t1.init(pool, LIST_T1);
+	_t2.init(pool, LIST_T2);
+	_b1 = GhostList{-1, -1, 0};
+	_b2 = GhostList{-1, -1, 0};
+}
+
+/**
+ * Allocates the ghosts pool, the lists and the ghosts together hold at most 2*capacity keys
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int ARCPolicy::init(const PolicyConfig& config)
+{
+	_capacity = config.capacity;
+	_p = 0;
+	_t1.init(_pool, LIST_T1);
+	_t2.init(_pool, LIST_T2);
+	_b1 = GhostList{-1, -1, 0};
+	_b2 = GhostList{-1, -1, 0};
+
+	try
+	{
+		_ghosts.resize(2*(size_t)_capacity);
+		_free_ghosts.clear();
+		_free_ghosts.reserve(2*(size_t)_capacity);
+		_ghost_index.clear();
+		_ghost_index.reserve(2*(size_t)_capacity);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	for (int ghost_id = 2*_capacity - 1; ghost_id >= 0; --ghost_id)
+		_free_ghosts.push_back(ghost_id);
+	return 0;
+}
+
+/**
+ * Appends T2 and then T1, each from its most recently used block
+ * The blocks of T1 were accessed once, so they are the first candidates for eviction
+ * @param ids the vector to append the ids to
+ */
+void ARCPolicy::order(std::vector<int>& ids) const
+{
+	for (int id = _t2.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+	for (int id = _t1.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+}
+
+/**
+ * Forgets the ghosts of a closed file
+ * @param file_id the closed file
+ */
+void ARCPolicy::forget(int file_id)
+{
+	for (GhostList* list : {&_b1, &_b2})
+	{
+		int ghost_id = list->head;
+		while (ghost_id != -1)
+		{
+			int next = _ghosts[ghost_id].next;
+			if ((uint32_t)(_ghosts[ghost_id].key >> 32) == (uint32_t)file_id)
+				ghost_remove(ghost_id);
+			ghost_id = next;
+		}
+	}
+}
+
+/**
+ * Adds a new block, a block remembered by a ghost list adapts the target size of T1
+ * and is added to T2, any other block is added to T1. A prefetched block only drops its ghost and is added to T1,
+ * so speculative reads don't move the target. The oldest ghosts are forgotten
+ * so T1 and B1 hold at most capacity keys, and all the lists hold at most 2*capacity keys
+ * @param block the new block
+ */
+void ARCPolicy::insert(Block& block)
+{
+	auto ghost_iter = _ghost_index.find(block_key(block.file_id, block.block_num));
+	int ghost_id = (ghost_iter == _ghost_index.end()) ? -1 : ghost_iter->second;
+	if (ghost_id != -1 && !block.prefetched)
+	{
+		_p = adapted_target(ghost_id);
+		ghost_remove(ghost_id);
+		_t2.push_back(block);
+	}
+	else
+	{
+		if (ghost_id != -1)
+			ghost_remove(ghost_id);
+		_t1.push_back(block);
+	}
+
+	while (_t1.size() + _b1.size > _capacity && _b1.size > 0)
+		ghost_remove(_b1.head);
+	while (_t1.size() + _t2.size() + _b1.size + _b2.size > 2*_capacity)
+		ghost_remove(_b2.size > 0 ? _b2.head : _b1.head);
+}
+
+/**
+ * Returns the least recently used block of T1 if T1 is bigger than its target, otherwise of T2
+ * When all the blocks of the chosen list are pinned, the other list is used
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int ARCPolicy::victim() const
+{
+	int t1_size = _t1.size();
+
+	int id;
+	if (t1_size > 0 && t1_size > _p)
+	{
+		id = first_unpinned(_t1);
+		return id != -1 ? id : first_unpinned(_t2);
+	}
+	id = first_unpinned(_t2);
+	return id != -1 ? id : first_unpinned(_t1);
+}
+
+/**
+ * Removes the block from its list, its key is remembered by the matching ghost list
+ * @param block a cached block
+ */
+void ARCPolicy::remove(Block& block)
+{
+	if (_t1.contains(block))
+	{
+		_t1.remove(block);
+		ghost_push_back(LIST_B1, block_key(block.file_id, block.block_num));
+	}
+	else
+	{
+		_t2.remove(block);
+		ghost_push_back(LIST_B2, block_key(block.file_id, block.block_num));
+	}
+}
+
+/**
+ * Returns the target size of T1 after the adaptation to a ghost hit
+ * A B1 ghost grows the target by |B2|/|B1| and a B2 ghost shrinks it by |B1|/|B2|, by at least 1
+ * @param ghost_id the ghost of the missing block
+ * @return the target size of T1
+ */
+int ARCPolicy::adapted_target(int ghost_id) const
+{
+	if (_ghosts[ghost_id].list == LIST_B1)
+		return std::min(_p + std::max(_b2.size/_b1.size, 1), _capacity);
+	return std::max(_p - std::max(_b1.size/_b2.size, 1), 0);
+}
+
+/**
+ * Adds a key to the most recently used end of a ghost list
+ * @param list_id the ghost list id
+ * @param key the block key
+ */
+void ARCPolicy::ghost_push_back(int list_id, uint64_t key)
+{
+	GhostList& list = ghost_list(list_id);
+	int ghost_id = _free_ghosts.back();
+	_free_ghosts.pop_back();
+
+	Ghost& ghost = _ghosts[ghost_id];
+	ghost.key = key;
+	ghost.list = list_id;
+	ghost.prev = list.tail;
+	ghost.next = -1;
+	if (list.tail == -1)
+		list.head = ghost_id;
+	else
+		_ghosts[list.tail].next = ghost_id;
+	list.tail = ghost_id;
+	list.size++;
+
+	_ghost_index[key] = ghost_id;
+}
+
+/**
+ * Forgets a ghost
+ * @param ghost_id the ghost index
+ */
+void ARCPolicy::ghost_remove(int ghost_id)
+{
+	Ghost& ghost = _ghosts[ghost_id];
+	GhostList& list = ghost_list(ghost.list);
+	if (ghost.prev == -1)
+		list.head = ghost.next;
+	else
+		_ghosts[ghost.prev].next = ghost.next;
+	if (ghost.next == -1)
+		list.tail = ghost.prev;
+	else
+		_ghosts[ghost.next].prev = ghost.prev;
+	list.size--;
+
+	_ghost_index.erase(ghost.key);
+	_free_ghosts.push_back(ghost_id);
+}
+
+/**
+ * Returns the first block of a list that isn't pinned
+ * @param list the list
+ * @return the block id, -1 if all the list blocks are pinned
+ */
+int ARCPolicy::first_unpinned(const BlockList& list) const
+{
+	int id = list.head();
+	while (id != -1 && _pool[id].pin_count > 0)
+		id = _pool[id].next;
+	return id;
+}
@@ -0,0 +1,163 @@
+#ifndef CACHEFS_ARCPOLICY_H
+#define CACHEFS_ARCPOLICY_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "BlockList.h"
+#include "CachePolicy.h"
+
+/**
+ * Adaptive replacement cache. The cached blocks are split between T1, the blocks that were accessed once
+ * since they were added, and T2, the blocks that were accessed again, both ordered by their last access.
+ * The ghost lists B1 and B2 remember the keys of the blocks that were recently evicted from T1 and T2,
+ * a miss on a B1 key grows the target size p of T1 and a miss on a B2 key shrinks it,
+ * so the cache moves between recency and frequency by itself.
+ * The ghost of a missing block is looked up when the block is added, after its victim was chosen, since the shard
+ * lock may be released in between, so the victim is chosen with the target from before the miss.
+ * Prefetched blocks don't adapt the target, they weren't requested yet.
+ */
+class ARCPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit ARCPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+	void forget(int file_id) override;
+
+	/**
+	 * Adds a new block, to T2 if its key is remembered by a ghost list, otherwise to T1
+	 */
+	void insert(Block& block);
+
+	/**
+	 * Moves the block to the most recently used end of T2
+	 */
+	void access(Block& block)
+	{
+		if (_t1.contains(block))
+			_t1.remove(block);
+		else
+			_t2.remove(block);
+		_t2.push_back(block);
+	}
+
+	/**
+	 * Returns the least recently used block of T1 if T1 is bigger than its target, otherwise of T2,
+	 * pinned blocks are skipped, -1 if all the blocks are pinned
+	 */
+	int victim() const;
+
+	/**
+	 * Removes the block from its list, its key is remembered by the matching ghost list
+	 */
+	void remove(Block& block);
+
+private:
+	/**
+	 * The list ids
+	 */
+	enum ListId {
+		LIST_T1 = 1,
+		LIST_T2 = 2,
+		LIST_B1 = 3,
+		LIST_B2 = 4
+	};
+
+	/**
+	 * The key of an evicted block
+	 */
+	struct Ghost {
+		uint64_t key;
+		int prev, next;
+		int list;
+	};
+
+	/**
+	 * A ghost list, an intrusive doubly linked list of ghost indices, ordered from the least recently used
+	 */
+	struct GhostList {
+		int head, tail;
+		int size;
+	};
+
+	/**
+	 * The cached blocks lists
+	 */
+	BlockList _t1;
+	BlockList _t2;
+
+	/**
+	 * The ghost lists
+	 */
+	GhostList _b1;
+	GhostList _b2;
+
+	/**
+	 * The ghosts pool, there are at most 2*capacity keys in all the lists, and the unused ghosts
+	 */
+	std::vector<Ghost> _ghosts;
+	std::vector<int> _free_ghosts;
+
+	/**
+	 * Maps a block key to its ghost
+	 */
+	std::unordered_map<uint64_t, int> _ghost_index;
+
+	/**
+	 * The max number of cached blocks
+	 */
+	int _capacity;
+
+	/**
+	 * The target size of T1
+	 */
+	int _p;
+
+	/**
+	 * Returns the target size of T1 after the adaptation to a ghost hit
+	 * @param ghost_id the ghost of the missing block
+	 */
+	int adapted_target(int ghost_id) const;
+
+	/**
+	 * Returns the key of a block
+	 */
+	static uint64_t block_key(int file_id, int block_num)
+	{
+		return ((uint64_t)(uint32_t)file_id << 32) | (uint32_t)block_num;
+	}
+
+	/**
+	 * Returns the ghost list with the given id
+	 */
+	GhostList& ghost_list(int list_id)
+	{
+		return list_id == LIST_B1 ? _b1 : _b2;
+	}
+
+	/**
+	 * Adds a key to the most recently used end of a ghost list
+	 * @param list_id the ghost list id
+	 * @param key the block key
+	 */
+	void ghost_push_back(int list_id, uint64_t key);
+
+	/**
+	 * Forgets a ghost
+	 * @param ghost_id the ghost index
+	 */
+	void ghost_remove(int ghost_id);
+
+	/**
+	 * Returns the first block of a list that isn't pinned, -1 if there isn't one
+	 * @param list the list
+	 */
+	int first_unpinned(const BlockList& list) const;
+};
+
+#endif //CACHEFS_ARCPOLICY_H
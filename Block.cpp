@@ -1,99 +1,38 @@
 #include "Block.h"
-#include <cstring>
-#include <new>
-#include <stdlib.h>
 
 /**
  * Default constructor
  */
-Block::Block() : reference_num(0), file_id(-1), block_num(-1), data_size(0), _block_size(-1) {}
+Block::Block() : reference_num(0), file_id(-1), block_num(-1), id(-1), data_size(0) {}
 
 /**
- * Block constructor
- * @param file_id the file the block is associated with
- * @param block_num the file block number
- * @param block_size the size of the block
+ * Attaches the block to its buffer, called once when the cache is initialized
+ * @param buffer a block size aligned buffer of block size bytes, owned by the cache
  * @param id unique block id
  */
-Block::Block(int file_id, int block_num, blksize_t block_size, int id) : reference_num(0), file_id(file_id), block_num(block_num),
-												    id(id), _block_size(block_size)
-{
-	buffer = aligned_alloc(_block_size, _block_size);
-	if (buffer == nullptr)
-		throw std::bad_alloc();
-	data_size = pread(file_id, buffer, _block_size, (block_num*_block_size));
-}
-
-/**
- * Destructor
- */
-Block::~Block()
-{
-	free(buffer);
-}
-
-/**
- * Copy constructor
- * @param rhs the block to copy
- */
-Block::Block(const Block& rhs) : reference_num(rhs.reference_num), file_id(rhs.file_id),
-								 block_num(rhs.block_num), id(rhs.id), _block_size(rhs._block_size)
-{
-	free(buffer);
-	buffer = aligned_alloc(_block_size, _block_size);
-	std::memcpy(buffer, rhs.buffer, _block_size);
-	data_size = rhs.data_size;
-}
-
-/**
- * Move constructor
- * @param rhs the block to move
- */
-Block::Block(Block&& rhs) : reference_num(rhs.reference_num), file_id(rhs.file_id), block_num(rhs.block_num),
-							id(rhs.id), _block_size(rhs._block_size)
+void Block::init(void* buffer, int id)
 {
-	free(buffer);
-	buffer= rhs.buffer;
-	rhs.buffer = nullptr;
-	data_size = rhs.data_size;
+	this->buffer = buffer;
+	this->id = id;
 }
 
 /**
- * Copy assignment operator
- * @param rhs the block to copy
- * @return this block
- */
-Block& Block::operator=(const Block& rhs)
-{
-	if (this == &rhs)
-		return *this;
-
-	copy_base(rhs);
-
-	free(buffer);
-	buffer = aligned_alloc(_block_size, _block_size);
-	std::memcpy(buffer, rhs.buffer, _block_size);
-	data_size = rhs.data_size;
-	return *this;
-}
-
-/**
- * Move assignment operator
- * @param rhs the block to move
- * @return this block
+ * Resets the block state and associates it with a file block
+ * @param file_id the file the block is associated with
+ * @param block_num the file block number
  */
-Block& Block::operator=(Block&& rhs)
+void Block::reset(int file_id, int block_num)
 {
-	if (this == &rhs)
-		return *this;
-
-	copy_base(rhs);
-
-	free(buffer);
-	buffer = rhs.buffer;
-	rhs.buffer = nullptr;
-	data_size = rhs.data_size;
-	return *this;
+	this->file_id = file_id;
+	this->block_num = block_num;
+	reference_num = 0;
+	prev = -1;
+	next = -1;
+	list = -1;
+	loading = false;
+	prefetched = false;
+	pin_count = 0;
+	data_size = 0;
 }
 
 /**
@@ -118,16 +57,3 @@ inline bool operator== (const Block& lhs, const Block& rhs)
 {
 	return lhs.id == rhs.id;
 }
-
-/**
- * Copy the basic data members
- * @param rhs the block to copy from
- */
-void Block::copy_base(const Block& rhs)
-{
-	file_id = rhs.file_id;
-	_block_size = rhs._block_size;
-	block_num = rhs.block_num;
-	reference_num = rhs.reference_num;
-	id = rhs.id;
-}
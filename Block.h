@@ -26,7 +26,7 @@ struct Block {
 	int id;
 
 	/**
-	 * Holds the block data
+	 * Holds the block data, a cell of the cache buffers arena
 	 */
 	void* buffer = nullptr;
 
@@ -36,49 +36,59 @@ struct Block {
 	ssize_t data_size;
 
 	/**
-	 * Default constructor
+	 * The id of the previous block in the cache algorithm list, -1 if there isn't one
 	 */
-	Block();
+	int prev = -1;
 
 	/**
-	 * Block constructor
-	 * @param file_id the file the block is associated with
-	 * @param block_num the file block number
-	 * @param block_size the size of the block
-	 * @param id unique block id
+	 * The id of the next block in the cache algorithm list, -1 if there isn't one
 	 */
-	Block(int file_id, int block_num, blksize_t block_size, int id);
+	int next = -1;
 
 	/**
-	 * Destructor
+	 * The cache algorithm list the block is linked in, -1 if there isn't one
 	 */
-	~Block();
+	int list = -1;
 
 	/**
-	 * Copy constructor
-	 * @param rhs the block to copy
+	 * True while the block data is being read from the file, data_size is set once it's read
 	 */
-	Block(const Block& rhs);
+	bool loading = false;
 
 	/**
-	 * Move constructor
-	 * @param rhs the block to move
+	 * True if the block was read by readahead and wasn't accessed yet
 	 */
-	Block(Block&& rhs);
+	bool prefetched = false;
 
 	/**
-	 * Copy assignment operator
-	 * @param rhs the block to copy
-	 * @return this block
+	 * The number of views of the block that weren't released, a pinned block can't be evicted
 	 */
-	Block& operator=(const Block& rhs);
+	int pin_count = 0;
 
 	/**
-	 * Move assignment operator
-	 * @param rhs the block to move
-	 * @return this block
+	 * Default constructor
 	 */
-	Block& operator=(Block&& rhs);
+	Block();
+
+	/**
+	 * Attaches the block to its buffer, called once when the cache is initialized
+	 * @param buffer a block size aligned buffer of block size bytes, owned by the cache
+	 * @param id unique block id
+	 */
+	void init(void* buffer, int id);
+
+	/**
+	 * Resets the block state and associates it with a file block
+	 * @param file_id the file the block is associated with
+	 * @param block_num the file block number
+	 */
+	void reset(int file_id, int block_num);
+
+	/**
+	 * Blocks are kept in a fixed array and refer to a buffer they don't own, so they can't be copied
+	 */
+	Block(const Block& rhs) = delete;
+	Block& operator=(const Block& rhs) = delete;
 
 	/**
 	 * Less than operator
@@ -96,18 +106,6 @@ struct Block {
 	 * @return true if block IDs equal, otherwise false.
 	 */
 	friend bool operator== (const Block& lhs, const Block& rhs);
-
-private:
-	/**
-	 * The file system block size
-	 */
-	blksize_t _block_size;
-
-	/**
-	 * Copy the basic data members
-	 * @param rhs the block to copy from
-	 */
-	void copy_base(const Block& rhs);
 };
 
 #endif //CACHEFS_BLOCK_H
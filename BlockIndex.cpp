@@ -0,0 +1,192 @@
+#include "BlockIndex.h"
+#include <new>
+
+/**
+ * The number of blocks in a page
+ */
+#define PAGE_BLOCKS (1 << BLOCK_INDEX_PAGE_SHIFT)
+
+/**
+ * Default constructor, creates an empty index that can't hold blocks
+ */
+BlockIndex::BlockIndex() : _pages(nullptr), _directory(nullptr), _directory_mask(0) {}
+
+/**
+ * Destructor
+ */
+BlockIndex::~BlockIndex()
+{
+	destroy();
+}
+
+/**
+ * Initializes an empty index
+ * @param capacity the max number of blocks in the index
+ * @return 0 if successful, otherwise -1.
+ */
+int BlockIndex::init(int capacity)
+{
+	destroy();
+	if (capacity <= 0)
+		return -1;
+
+	uint64_t directory_size = 1;
+	while (directory_size < 2*(uint64_t)capacity)
+		directory_size *= 2;
+
+	_pages = new (std::nothrow) Page[capacity];
+	_directory = new (std::nothrow) DirectoryEntry[directory_size];
+	try
+	{
+		_free_pages.reserve(capacity);
+	} catch (std::bad_alloc& e)
+	{
+		destroy();
+		return -1;
+	}
+	if (_pages == nullptr || _directory == nullptr)
+	{
+		destroy();
+		return -1;
+	}
+
+	_directory_mask = directory_size - 1;
+	for (uint64_t i = 0; i < directory_size; ++i)
+		store(_directory[i].page, -1);
+	// the free pages stack has the lowest page at the top
+	for (int page = capacity - 1; page >= 0; --page)
+		_free_pages.push_back(page);
+	return 0;
+}
+
+/**
+ * Releases the pages and the directory
+ */
+void BlockIndex::destroy()
+{
+	delete[] _pages;
+	delete[] _directory;
+	_pages = nullptr;
+	_directory = nullptr;
+	_directory_mask = 0;
+	_free_pages.clear();
+}
+
+/**
+ * Finds a block in the index
+ * @param file_id the file the block belongs to
+ * @param block_num the block number within the file
+ * @return the block id, -1 if the block isn't in the index
+ */
+int BlockIndex::find(int file_id, int block_num) const
+{
+	if (_directory == nullptr)
+		return -1;
+
+	int page = _directory[find_entry(page_key(file_id, block_num))].page;
+	if (page == -1)
+		return -1;
+	return _pages[page].block_ids[block_num & (PAGE_BLOCKS - 1)];
+}
+
+/**
+ * Finds a block in the index without holding the lock that protects it
+ * The fields are read with atomic loads. A directory entry that is moved back while it's probed is missed,
+ * and an entry that changes while it's read may give a wrong id, so the caller must check the block it gets
+ * @param file_id the file the block belongs to
+ * @param block_num the block number within the file
+ * @return a block id, -1 if the block wasn't found
+ */
+int BlockIndex::find_unlocked(int file_id, int block_num) const
+{
+	if (_directory == nullptr)
+		return -1;
+
+	uint64_t key = page_key(file_id, block_num);
+	uint64_t i = home_entry(key);
+	for (uint64_t probes = 0; probes <= _directory_mask; ++probes)
+	{
+		int page = __atomic_load_n(&_directory[i].page, __ATOMIC_RELAXED);
+		if (page == -1)
+			return -1;
+		if (__atomic_load_n(&_directory[i].key, __ATOMIC_RELAXED) == key)
+			return __atomic_load_n(&_pages[page].block_ids[block_num & (PAGE_BLOCKS - 1)], __ATOMIC_RELAXED);
+		i = (i + 1) & _directory_mask;
+	}
+	return -1;
+}
+
+/**
+ * Adds a block to the index, the block must not be in the index already and the index must not be full
+ * The first block of a page takes a page from the pool
+ * @param file_id the file the block belongs to
+ * @param block_num the block number within the file
+ * @param block_id the block id
+ */
+void BlockIndex::insert(int file_id, int block_num, int block_id)
+{
+	uint64_t key = page_key(file_id, block_num);
+	DirectoryEntry& entry = _directory[find_entry(key)];
+	if (entry.page == -1)
+	{
+		int page_id = _free_pages.back();
+		_free_pages.pop_back();
+		Page& page = _pages[page_id];
+		page.used = 0;
+		for (int j = 0; j < PAGE_BLOCKS; ++j)
+			store(page.block_ids[j], -1);
+		store(entry.key, key);
+		store(entry.page, page_id);
+	}
+
+	Page& page = _pages[entry.page];
+	store(page.block_ids[block_num & (PAGE_BLOCKS - 1)], block_id);
+	page.used++;
+}
+
+/**
+ * Removes a block from the index if it exists
+ * An empty page returns to the pool and its directory entry is removed, the following entries of its probe
+ * sequence are moved back so the directory never has deleted entries
+ * @param file_id the file the block belongs to
+ * @param block_num the block number within the file
+ */
+void BlockIndex::erase(int file_id, int block_num)
+{
+	if (find(file_id, block_num) == -1)
+		return;
+
+	uint64_t hole = find_entry(page_key(file_id, block_num));
+	Page& page = _pages[_directory[hole].page];
+	store(page.block_ids[block_num & (PAGE_BLOCKS - 1)], -1);
+	if (--page.used > 0)
+		return;
+
+	_free_pages.push_back(_directory[hole].page);
+	for (uint64_t i = (hole + 1) & _directory_mask; _directory[i].page != -1; i = (i + 1) & _directory_mask)
+	{
+		// an entry can fill the hole if its home isn't between the hole and the entry
+		uint64_t home = home_entry(_directory[i].key);
+		if (((i - home) & _directory_mask) >= ((i - hole) & _directory_mask))
+		{
+			store(_directory[hole].key, _directory[i].key);
+			store(_directory[hole].page, _directory[i].page);
+			hole = i;
+		}
+	}
+	store(_directory[hole].page, -1);
+}
+
+/**
+ * Returns the directory entry of a key, or the empty entry where it would be added
+ * The directory is at most half full, so there is always an empty entry
+ * @param key the page key
+ * @return the directory entry index
+ */
+uint64_t BlockIndex::find_entry(uint64_t key) const
+{
+	uint64_t i = home_entry(key);
+	while (_directory[i].page != -1 && _directory[i].key != key)
+		i = (i + 1) & _directory_mask;
+	return i;
+}
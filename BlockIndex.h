@@ -0,0 +1,152 @@
+#ifndef CACHEFS_BLOCKINDEX_H
+#define CACHEFS_BLOCKINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * log2 of the number of blocks in a block index page
+ */
+#define BLOCK_INDEX_PAGE_SHIFT 6
+
+/**
+ * Paged table that maps a (file, block number) pair to the id of the cached block.
+ * A page holds the ids of 2^BLOCK_INDEX_PAGE_SHIFT consecutive blocks of a file, and the directory is an open
+ * addressing table from (file, page number) to the page, so a lookup is a directory probe and a page load,
+ * and the blocks of a page share a single directory entry.
+ * The pages and the directory are allocated by init for the max number of blocks, one page per block at worst,
+ * so the memory follows the number of cached blocks rather than the file sizes, and adding a block never allocates.
+ * The directory is hashed on purpose: a per-file array of pages indexed by page number would make a lookup two
+ * loads with no hashing, but its size follows the highest cached block of the file (32 MiB of pointers for a single
+ * block near the end of a 1 TiB file) and it has to grow on the miss path. The hash is a single multiplication and
+ * the directory is at most half full, so a lookup is usually the hash, one directory entry and the page.
+ * The pages and the directory are never released while the index is used and their fields are written with atomic
+ * stores, so find_unlocked can probe the index while another thread changes it.
+ */
+class BlockIndex {
+public:
+	/**
+	 * Default constructor, creates an empty index that can't hold blocks
+	 */
+	BlockIndex();
+
+	/**
+	 * Destructor
+	 */
+	~BlockIndex();
+
+	/**
+	 * Initializes an empty index
+	 * @param capacity the max number of blocks in the index
+	 * @return 0 if successful, otherwise -1.
+	 */
+	int init(int capacity);
+
+	/**
+	 * Releases the pages and the directory
+	 */
+	void destroy();
+
+	/**
+	 * Finds a block in the index
+	 * @param file_id the file the block belongs to
+	 * @param block_num the block number within the file
+	 * @return the block id, -1 if the block isn't in the index
+	 */
+	int find(int file_id, int block_num) const;
+
+	/**
+	 * Finds a block in the index without holding the lock that protects it
+	 * The result may be wrong while the index is changed, the caller must check the block it gets
+	 * @param file_id the file the block belongs to
+	 * @param block_num the block number within the file
+	 * @return a block id, -1 if the block wasn't found
+	 */
+	int find_unlocked(int file_id, int block_num) const;
+
+	/**
+	 * Adds a block to the index, the block must not be in the index already and the index must not be full
+	 * @param file_id the file the block belongs to
+	 * @param block_num the block number within the file
+	 * @param block_id the block id
+	 */
+	void insert(int file_id, int block_num, int block_id);
+
+	/**
+	 * Removes a block from the index if it exists
+	 * @param file_id the file the block belongs to
+	 * @param block_num the block number within the file
+	 */
+	void erase(int file_id, int block_num);
+
+	BlockIndex(const BlockIndex&) = delete;
+	BlockIndex& operator=(const BlockIndex&) = delete;
+
+private:
+	/**
+	 * The block ids of consecutive blocks, an empty slot is -1
+	 */
+	struct Page {
+		int used;
+		int block_ids[1 << BLOCK_INDEX_PAGE_SHIFT];
+	};
+
+	/**
+	 * A directory entry, the key of a page and its index in the pages pool, an empty entry has page -1
+	 */
+	struct DirectoryEntry {
+		uint64_t key;
+		int page;
+	};
+
+	/**
+	 * The pages pool, one page per block, and the unused pages
+	 */
+	Page* _pages;
+	std::vector<int> _free_pages;
+
+	/**
+	 * The directory, a power of two entries, at least twice the number of pages, with linear probing
+	 */
+	DirectoryEntry* _directory;
+	uint64_t _directory_mask;
+
+	/**
+	 * Returns the directory key of the page that holds a block
+	 * @param file_id the file the block belongs to
+	 * @param block_num the block number within the file
+	 */
+	static uint64_t page_key(int file_id, int block_num)
+	{
+		return ((uint64_t)(uint32_t)file_id << 32) | ((uint32_t)block_num >> BLOCK_INDEX_PAGE_SHIFT);
+	}
+
+	/**
+	 * Returns the directory entry a key is placed at when there are no collisions
+	 * @param key the page key
+	 */
+	uint64_t home_entry(uint64_t key) const
+	{
+		return ((key*0x9E3779B97F4A7C15ULL) >> 32) & _directory_mask;
+	}
+
+	/**
+	 * Returns the directory entry of a key, or the empty entry where it would be added
+	 * @param key the page key
+	 */
+	uint64_t find_entry(uint64_t key) const;
+
+	/**
+	 * Stores a value that find_unlocked might read
+	 * @param field the field
+	 * @param value the new value
+	 */
+	template <class T>
+	static void store(T& field, T value)
+	{
+		__atomic_store_n(&field, value, __ATOMIC_RELAXED);
+	}
+};
+
+#endif //CACHEFS_BLOCKINDEX_H
@@ -0,0 +1,121 @@
+#ifndef CACHEFS_BLOCKLIST_H
+#define CACHEFS_BLOCKLIST_H
+
+#include "Block.h"
+
+/**
+ * An intrusive doubly linked list of blocks, threaded through the block prev and next ids.
+ * A block is linked in at most one list at a time, its list field holds the id of that list.
+ * The list is used on every block access, so it's defined in the header.
+ */
+class BlockList {
+public:
+	/**
+	 * Initializes an empty list
+	 * @param pool the cache block pool, block ids are indices in it
+	 * @param list_id the id the list blocks are marked with
+	 */
+	void init(Block* pool, int list_id)
+	{
+		_pool = pool;
+		_id = list_id;
+		_head = -1;
+		_tail = -1;
+		_size = 0;
+	}
+
+	/**
+	 * Returns the first block of the list, -1 if the list is empty
+	 */
+	int head() const
+	{
+		return _head;
+	}
+
+	/**
+	 * Returns the last block of the list, -1 if the list is empty
+	 */
+	int tail() const
+	{
+		return _tail;
+	}
+
+	/**
+	 * Returns the number of blocks in the list
+	 */
+	int size() const
+	{
+		return _size;
+	}
+
+	/**
+	 * Returns true if the block is linked in this list
+	 */
+	bool contains(const Block& block) const
+	{
+		return block.list == _id;
+	}
+
+	/**
+	 * Adds a block to the end of the list
+	 * @param block a block that isn't in a list
+	 */
+	void push_back(Block& block)
+	{
+		block.prev = _tail;
+		block.next = -1;
+		if (_tail == -1)
+			_head = block.id;
+		else
+			_pool[_tail].next = block.id;
+		_tail = block.id;
+
+		block.list = _id;
+		_size++;
+	}
+
+	/**
+	 * Removes a block from the list
+	 * @param block a block in the list
+	 */
+	void remove(Block& block)
+	{
+		if (block.prev == -1)
+			_head = block.next;
+		else
+			_pool[block.prev].next = block.next;
+		if (block.next == -1)
+			_tail = block.prev;
+		else
+			_pool[block.next].prev = block.prev;
+
+		block.prev = -1;
+		block.next = -1;
+		block.list = -1;
+		_size--;
+	}
+
+private:
+	/**
+	 * The cache block pool
+	 */
+	Block* _pool;
+
+	/**
+	 * The list id
+	 */
+	int _id;
+
+	/**
+	 * The first and last blocks of the list
+	 */
+	int _head;
+	int _tail;
+
+	/**
+	 * The number of blocks in the list
+	 */
+	int _size;
+};
+
+#endif //CACHEFS_BLOCKLIST_H
@@ -1,14 +1,36 @@
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
-#include <set>
-#include <map>
+#include <limits.h>
+#include <stdint.h>
 #include <algorithm>
-#include <deque>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <new>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <iostream>
 #include <string.h>
 #include <stdlib.h>
 #include "CacheFS.h"
 #include "Block.h"
+#include "BlockIndex.h"
+#include "IoEngine.h"
+#include "LRUPolicy.h"
+#include "LFUPolicy.h"
+#include "FBRPolicy.h"
+#include "ARCPolicy.h"
+#include "LIRSPolicy.h"
+#include "TinyLFUPolicy.h"
+#include "ClockProPolicy.h"
+#include "S3FIFOPolicy.h"
+#include "GDSFPolicy.h"
+#include "SampledPolicy.h"
 
 //--------------------------- definitions ----------------------------------------
 /**
@@ -24,10 +46,387 @@
  * Generates a caches hits log string
  */
 #define HITS_LOG(x) std::string("Hits number: " + std::to_string(x) + "\n")
+/**
+ * Generates the prefetch statistics log string
+ */
+#define PREFETCH_LOG(prefetched, hits, wasted) std::string("Prefetched blocks: " + std::to_string(prefetched) + "\n" + \
+	"Prefetch hits: " + std::to_string(hits) + "\n" + "Prefetch wasted: " + std::to_string(wasted) + "\n")
 /**
  * Log file permissions
  */
 #define LOG_PERMISSIONS 0666
+/**
+ * The max number of cache shards
+ */
+#define MAX_SHARDS 16
+/**
+ * The min number of blocks in a shard, smaller caches aren't split into shards
+ */
+#define MIN_SHARD_BLOCKS 1024
+/**
+ * The max number of consecutive missing blocks that are read from the file at once
+ */
+#define MAX_RUN_BLOCKS 256
+/**
+ * The size of the first readahead window of a sequential stream, in blocks
+ */
+#define INITIAL_READAHEAD_BLOCKS 4
+/**
+ * The max number of asynchronous reads in flight
+ */
+#define ASYNC_READS 256
+
+//---------------------------- types ----------------------------------------------
+/**
+ * Lets threads read a loaded block without the shard lock, for the algorithms with UNLOCKED_ACCESS
+ * The block is published with its key while it can be read, and readers count themselves while they copy it
+ */
+struct ReadGuard {
+	/**
+	 * The key of the block while it's loaded and can be read without the shard lock, NO_KEY otherwise
+	 */
+	std::atomic<uint64_t> published_key;
+
+	/**
+	 * The number of threads that are reading the block without the shard lock
+	 */
+	std::atomic<int> readers;
+
+	/**
+	 * The published key of a block that can't be read without the shard lock
+	 */
+	static const uint64_t NO_KEY = UINT64_MAX;
+
+	ReadGuard() : published_key(NO_KEY), readers(0) {}
+
+	/**
+	 * Returns the published key of a file block
+	 * @param file_id the file the block belongs to
+	 * @param block_num the block number
+	 */
+	static uint64_t key(int file_id, int block_num)
+	{
+		return ((uint64_t)(uint32_t)file_id << 32) | (uint32_t)block_num;
+	}
+
+	/**
+	 * Lets threads read the loaded block without the shard lock, the shard lock must be held
+	 * The release store orders the block data before the key
+	 * @param block the loaded block
+	 */
+	void publish(const Block& block)
+	{
+		published_key.store(key(block.file_id, block.block_num), std::memory_order_release);
+	}
+
+	/**
+	 * Stops the reads without the shard lock and waits for the current ones to end, the shard lock must be held
+	 * A reader counts itself before it checks the key and this thread clears the key before it checks the readers,
+	 * both sequentially consistent, so either the reader sees the cleared key or this thread waits for the reader
+	 */
+	void unpublish()
+	{
+		if (published_key.load(std::memory_order_relaxed) == NO_KEY)
+			return;
+		published_key.store(NO_KEY);
+		while (readers.load() > 0)
+			std::this_thread::yield();
+	}
+
+	/**
+	 * Starts a read without the shard lock, the block data can't change until read_end is called
+	 * @param file_id the file of the requested block
+	 * @param block_num the requested block number
+	 * @return true if the block is the requested block and it's published, otherwise the read didn't start
+	 */
+	bool read_begin(int file_id, int block_num)
+	{
+		readers.fetch_add(1);
+		if (published_key.load() == key(file_id, block_num))
+			return true;
+		readers.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+
+	/**
+	 * Ends a read that was started by read_begin
+	 */
+	void read_end()
+	{
+		readers.fetch_sub(1, std::memory_order_release);
+	}
+};
+
+/**
+ * A part of the cache with its own lock, block ids, block index and cache algorithm state
+ * Every (file, block number) pair belongs to a single shard, so threads that access blocks
+ * of different shards don't wait for each other
+ */
+struct Shard {
+	/**
+	 * Protects all the shard data and the blocks with ids in the shard range
+	 */
+	std::mutex lock;
+
+	/**
+	 * Notified whenever a block of the shard finishes loading
+	 */
+	std::condition_variable block_loaded;
+
+	/**
+	 * The shard block ids are [first_id, first_id + capacity)
+	 */
+	int first_id = 0;
+
+	/**
+	 * Max number of blocks in the shard
+	 */
+	int capacity = 0;
+
+	/**
+	 * Counter of the blocks currently saved in the shard
+	 */
+	int blocks_counter = 0;
+
+	/**
+	 * Stack of the unused block ids of the shard (free cells of pBlockArray), the next id to use is at the top
+	 */
+	std::vector<int> free_ids;
+
+	/**
+	 * Paged table used to find a cached block by its file descriptor and block number
+	 * (fd, block_num)->block id, holds the pages of the files that belong to the shard
+	 */
+	BlockIndex block_index;
+
+	/**
+	 * Maps a file descriptor to the moving average of the time in microseconds it took to read a block of the file,
+	 * measured by run_flush for the file blocks that belong to the shard
+	 */
+	std::unordered_map<int, double> miss_latency;
+
+	/**
+	 * The shard cache algorithm, its type is the cache algorithm chosen by CacheFS_init
+	 */
+	CachePolicy* policy = nullptr;
+
+	/**
+	 * The read guards of the shard blocks, indexed by block id - first_id,
+	 * allocated only for the algorithms with UNLOCKED_ACCESS
+	 */
+	ReadGuard* read_guards = nullptr;
+
+	/**
+	 * Counter for the shard cache hits
+	 */
+	size_t hit_counter = 0;
+
+	/**
+	 * Counter for the shard cache hits that didn't take the shard lock
+	 */
+	std::atomic<size_t> unlocked_hit_counter;
+
+	/**
+	 * Counter for the shard cache misses
+	 */
+	size_t miss_counter = 0;
+
+	/**
+	 * Counters for the blocks read by readahead, the demand accesses to them
+	 * and the ones that were removed before any demand access
+	 */
+	size_t prefetch_counter = 0;
+	size_t prefetch_hit_counter = 0;
+	size_t prefetch_wasted_counter = 0;
+
+	Shard() : unlocked_hit_counter(0) {}
+
+	~Shard()
+	{
+		delete policy;
+		delete[] read_guards;
+	}
+};
+
+/**
+ * The sequential access detector and readahead window of an open file
+ */
+struct ReadaheadState {
+	/**
+	 * The offset right after the last read, a read from this offset continues the stream
+	 */
+	off_t next_offset = -1;
+
+	/**
+	 * The current readahead window size in blocks, 0 if the file isn't read sequentially
+	 */
+	int window = 0;
+
+	/**
+	 * The first block that was prefetched for the current stream
+	 */
+	int first_block = 0;
+
+	/**
+	 * The first block that wasn't prefetched yet
+	 */
+	int next_block = 0;
+
+	/**
+	 * The first block of the last window, the next window is prefetched once a read reaches it
+	 */
+	int marker = 0;
+};
+
+/**
+ * A requested range of a file and the buffers it's read into
+ */
+struct ReadOutput {
+	/**
+	 * The requested range and the output buffers, the range is scattered over the buffers in order
+	 */
+	off_t offset;
+	size_t count;
+	const struct iovec* buffers;
+	int buffers_num;
+
+	/**
+	 * The output buffer that was used last and its position in the requested range,
+	 * the blocks are usually copied in order so the next copy starts looking from it
+	 */
+	int buffer_index = 0;
+	size_t buffer_start = 0;
+
+	/**
+	 * The number of bytes copied to the output buffers
+	 */
+	size_t copied = 0;
+};
+
+struct PrefetchRun;
+
+/**
+ * The missing blocks state of a single read call
+ * Consecutive missing blocks are added to the cache as loading blocks and collected in a run,
+ * the whole run is read from the file with a single vectored read
+ */
+struct MissRun {
+	/**
+	 * The file descriptor of the file that is read
+	 */
+	int fd;
+
+	/**
+	 * The output the blocks are copied to once they are read, nullptr if they are only read into the cache
+	 */
+	ReadOutput* output = nullptr;
+
+	/**
+	 * True if reading a block failed
+	 */
+	bool failed = false;
+
+	/**
+	 * The block number of the first block in the run
+	 */
+	int first_block_num = 0;
+
+	/**
+	 * The number of blocks in the run
+	 */
+	int size = 0;
+
+	/**
+	 * The run blocks, ordered by block number
+	 */
+	Block* blocks[MAX_RUN_BLOCKS];
+
+	/**
+	 * The prefetch run that is being collected, its blocks are loading but their read wasn't queued yet
+	 */
+	PrefetchRun* prefetch = nullptr;
+};
+
+/**
+ * A block access of a batch read request
+ */
+struct BatchAccess {
+	int fd;
+	int block_num;
+	int request;
+
+	bool operator<(const BatchAccess& rhs) const
+	{
+		if (fd != rhs.fd)
+			return fd < rhs.fd;
+		if (block_num != rhs.block_num)
+			return block_num < rhs.block_num;
+		return request < rhs.request;
+	}
+};
+
+/**
+ * Consecutive prefetched blocks that are read in the background with a single read
+ */
+struct PrefetchRun {
+	/**
+	 * The file descriptor of the file that is read
+	 */
+	int fd;
+
+	/**
+	 * The number of blocks in the run
+	 */
+	int size = 0;
+
+	/**
+	 * The run blocks, ordered by block number, and their buffers
+	 */
+	Block* blocks[MAX_RUN_BLOCKS];
+	struct iovec iov[MAX_RUN_BLOCKS];
+
+	/**
+	 * The time the read was queued
+	 */
+	std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * Identifies a file by its device and inode numbers, all the names of a file have the same key
+ */
+struct FileKey {
+	dev_t dev;
+	ino_t ino;
+
+	bool operator==(const FileKey& rhs) const
+	{
+		return dev == rhs.dev && ino == rhs.ino;
+	}
+};
+
+/**
+ * Hashes a file key
+ */
+struct FileKeyHash {
+	size_t operator()(const FileKey& key) const
+	{
+		return std::hash<uint64_t>()((uint64_t) key.ino * 0x9E3779B97F4A7C15ULL ^ (uint64_t) key.dev);
+	}
+};
+
+/**
+ * The cache engine functions that depend on the cache algorithm
+ * Each cache algorithm has its own instance of the engine templates, the instance of the chosen algorithm
+ * is picked once by CacheFS_init, so the algorithm calls inside the engine aren't dispatched at runtime
+ */
+struct CacheEngine {
+	CachePolicy* (*create_policy)(const PolicyConfig& config);
+	Block* (*get_block)(Shard& shard, std::unique_lock<std::mutex>& lock, int fd, int block_num, MissRun& run);
+	Block* (*prefetch_block)(Shard& shard, std::unique_lock<std::mutex>& lock, int fd, int block_num, MissRun& run);
+	void (*remove_block)(Shard& shard, int block_id);
+	void (*update_miss_cost)(Shard& shard, Block* block_p, double latency);
+	bool (*read_unlocked)(Shard& shard, int fd, int block_num, ReadOutput& output);
+};
 
 //---------------------------- global variables -----------------------------------
 /**
@@ -39,22 +438,31 @@ blksize_t BLOCK_SIZE;
  */
 int MAX_BLOCKS;
 /**
- * Counter of the blocks currently saved in the cache
- */
-int g_blocks_counter = 0;
-/**
- * Data structure used to map a file descriptor to its blocks
- * fd->set<Block>
+ * The cache shards, the number of shards is a power of 2
  */
-std::map<int, std::set<Block*>*> file_block_map;
+Shard* pShards;
 /**
- * Queue of pairs representing blocks, <file_descriptor, block_id>
+ * The number of cache shards
  */
-std::deque<int> block_queue;
+int g_shards_num = 0;
 /**
  * Array of block object pointers, each block is allocated to a free cell where block ID number == cell index
+ * A used cell points to the block with the same index in the block pool, an unused cell is nullptr
  */
 Block** pBlockArray;
+/**
+ * The block objects, allocated once when the cache is initialized
+ */
+Block* pBlockPool;
+/**
+ * The blocks data buffers, one BLOCK_SIZE aligned buffer of BLOCK_SIZE bytes per block id
+ */
+void* pBufferArena;
+/**
+ * Protects the open files data structures
+ * When both are needed, this lock is taken before a shard lock
+ */
+std::mutex g_files_lock;
 /**
  * Maps file descriptors to path strings
  */
@@ -62,11 +470,40 @@ std::map<int, std::string> fd_path_map;
 /**
  * maps a cache fs file descriptor to its original file descriptor
  */
-std::map<int, int> cachefd_origfd_map;
+std::unordered_map<int, int> cachefd_origfd_map;
 /**
  * Maps file descriptor to file size
  */
 std::map<int, off_t> fd_size_map;
+/**
+ * Maps an open file key to its file descriptor, a file is opened once no matter which name is used
+ */
+std::unordered_map<FileKey, int, FileKeyHash> inode_fd_map;
+/**
+ * Maps file descriptor to its file key
+ */
+std::unordered_map<int, FileKey> fd_inode_map;
+/**
+ * Maps file descriptor to the number of cache fs file descriptors that use it
+ */
+std::unordered_map<int, int> fd_refs_map;
+/**
+ * Maps a cache fs file descriptor to its readahead state
+ */
+std::map<int, ReadaheadState> cachefd_readahead_map;
+/**
+ * The max readahead window in blocks, 0 if readahead is disabled
+ * Written under g_files_lock, atomic since reads check it before taking the lock
+ */
+std::atomic<int> g_readahead_max(0);
+/**
+ * Reads prefetched blocks in the background, when it's inactive they are read with the run of missing blocks
+ */
+IoEngine g_io_engine;
+/**
+ * The cache engine of the cache algorithm
+ */
+CacheEngine g_engine;
 /**
  * The cache fs algorithm
  */
@@ -79,33 +516,39 @@ double PART_OLD;
  * The percentage of blocks in the new partition (rounding down) relevant in FBR algorithm only
  */
 double PART_NEW;
-/**
- * Counter for the cache hits
- */
-size_t g_hit_counter = 0;
-/**
- * Counter for the cache misses
- */
-size_t g_miss_counter = 0;
 
 //--------------------------------- function definitions -----------------------------------------------
 
 static blksize_t get_block_size();
-static Block* create_block(int fd, int block_num);
-static void LRU_update_queue(Block& block_p);
-static void LFU_update_queue(Block& block_p);
-static void FBR_update_queue(Block* block_p);
-static void make_room();
-static void LRU_make_room();
-static void LFU_make_room();
-static void FBR_make_room();
-static bool FBR_block_is_new(Block& block);
-static int get_free_id();
-static Block* get_block(int fd, int block_num);
-static void update_queue(Block* block_p);
-static void remove_block(int block_id);
-static off_t get_file_size(const char* path);
+static Shard& get_shard(int fd, int block_num);
+template <class Policy> static CacheEngine engine_for();
+template <class Policy> static CachePolicy* create_policy(const PolicyConfig& config);
+template <class Policy> static Block* create_block(Shard& shard, int fd, int block_num, bool prefetched);
+template <class Policy> static int make_room(Shard& shard, std::unique_lock<std::mutex>& lock, MissRun& run);
+static int get_free_id(Shard& shard);
+template <class Policy>
+static Block* get_block(Shard& shard, std::unique_lock<std::mutex>& lock, int fd, int block_num, MissRun& run);
+template <class Policy> static bool read_unlocked(Shard& shard, int fd, int block_num, ReadOutput& output);
+template <class Policy>
+static Block* prefetch_block(Shard& shard, std::unique_lock<std::mutex>& lock, int fd, int block_num, MissRun& run);
+static void prefetch_range(int fd, off_t file_size, int first_block, int last_block, MissRun& run);
+static void prefetch_submit(PrefetchRun*& prefetch, MissRun& run);
+static void prefetch_done(uint64_t tag, ssize_t result);
+static void readahead_update(ReadaheadState& state, off_t offset, size_t count, bool wasted,
+							 int& first_block, int& last_block);
+static void wait_for_block(Shard& shard, std::unique_lock<std::mutex>& lock, MissRun& run);
+static void run_add(MissRun& run, Block* block_p);
+static void run_flush(MissRun& run);
+template <class Policy> static void update_miss_cost(Shard& shard, Block* block_p, double latency);
+static int read_file(int file_id, const struct iovec* iov, int iovcnt, size_t count, off_t offset);
+static size_t copy_block_data(const Block& block, ReadOutput& output);
+template <class Policy> static void remove_block(Shard& shard, int block_id);
+static Shard& get_id_shard(int block_id);
 static int get_unique_cache_fd();
+static void remove_file_blocks(int fd);
+static void free_blocks();
+static int init_shards(int blocks_num);
+static ssize_t print_block(int log_fd, const Block& block);
 
 //------------------------------- CacheFS functions implementation ----------------------------------
 
@@ -135,16 +578,83 @@ int CacheFS_init(int blocks_num, cache_algo_t cache_algo, double f_old , double
 	// initialize global variables
 	MAX_BLOCKS = blocks_num;
 	CACHE_ALGO = cache_algo;
+	g_readahead_max = 0;
 	PART_OLD = f_old;
 	PART_NEW = f_new;
 
+	// pick the cache engine of the cache algorithm
+	switch (cache_algo)
+	{
+		case LRU:
+			g_engine = engine_for<LRUPolicy>();
+			break;
+		case LFU:
+			g_engine = engine_for<LFUPolicy>();
+			break;
+		case FBR:
+			g_engine = engine_for<FBRPolicy>();
+			break;
+		case ARC:
+			g_engine = engine_for<ARCPolicy>();
+			break;
+		case LIRS:
+			g_engine = engine_for<LIRSPolicy>();
+			break;
+		case TINYLFU:
+			g_engine = engine_for<TinyLFUPolicy>();
+			break;
+		case CLOCKPRO:
+			g_engine = engine_for<ClockProPolicy>();
+			break;
+		case S3FIFO:
+			g_engine = engine_for<S3FIFOPolicy>();
+			break;
+		case GDSF:
+			g_engine = engine_for<GDSFPolicy>();
+			break;
+		case SAMPLED_LRU:
+			g_engine = engine_for<SampledLRUPolicy>();
+			break;
+		case SAMPLED_LFU:
+			g_engine = engine_for<SampledLFUPolicy>();
+			break;
+		default:
+			return -1;
+	}
+
+	// Initialize the blocks pool and their buffers
+	pBufferArena = aligned_alloc(BLOCK_SIZE, (size_t)BLOCK_SIZE*blocks_num);
+	if (pBufferArena == nullptr)
+		return -1;
+	pBlockPool = new (std::nothrow) Block[blocks_num];
+	if (pBlockPool == nullptr)
+	{
+		free_blocks();
+		return -1;
+	}
+	for (int i = 0; i < blocks_num; ++i)
+		pBlockPool[i].init((char*)pBufferArena + (size_t)BLOCK_SIZE*i, i);
+
 	// Initialize the block array
 	pBlockArray = (Block**) malloc(sizeof(Block*)*blocks_num);
 	if (pBlockArray == nullptr)
+	{
+		free_blocks();
 		return -1;
+	}
 	for (int i = 0; i < blocks_num; ++i)
 		pBlockArray[i] = nullptr;
 
+	// Split the blocks between the shards
+	if (init_shards(blocks_num) == -1)
+	{
+		free_blocks();
+		return -1;
+	}
+
+	// Start the background reads engine, without it prefetched blocks are read synchronously
+	g_io_engine.init(pBufferArena, (size_t)BLOCK_SIZE*blocks_num, BLOCK_SIZE, ASYNC_READS, prefetch_done);
+
 	return 0;
 }
 
@@ -156,24 +666,41 @@ int CacheFS_init(int blocks_num, cache_algo_t cache_algo, double f_old , double
  */
 int CacheFS_destroy()
 {
-	// free allocated memory
-	for (int i = 0; i < MAX_BLOCKS; ++i)
-		if (pBlockArray[i] != nullptr)
-			delete pBlockArray[i];
-	free(pBlockArray);
+	// wait for the background reads before their buffers are released
+	g_io_engine.destroy();
+
+	// free allocated memory, the shards hold the cache algorithm data structures and counters
+	delete[] pShards;
+	pShards = nullptr;
+	g_shards_num = 0;
+	free_blocks();
 
 	// clear data structures
-	block_queue.clear();
-	file_block_map.clear();
 	fd_path_map.clear();
 	cachefd_origfd_map.clear();
 	fd_size_map.clear();
+	cachefd_readahead_map.clear();
+	inode_fd_map.clear();
+	fd_inode_map.clear();
+	fd_refs_map.clear();
+
+	return 0;
+}
 
-	// reset global counters
-	g_blocks_counter = 0;
-	g_hit_counter = 0;
-	g_miss_counter = 0;
+/**
+ * Enables sequential readahead
+ * @param max_blocks the max readahead window in blocks, 0 disables readahead
+ * @return 0 if successful, otherwise -1.
+ */
+int CacheFS_set_readahead(int max_blocks)
+{
+	// a window bigger than half of the cache would evict itself before it's read
+	if (max_blocks < 0 || max_blocks > MAX_BLOCKS/2)
+		return -1;
 
+	std::lock_guard<std::mutex> files_lock(g_files_lock);
+	g_readahead_max = max_blocks;
+	cachefd_readahead_map.clear();
 	return 0;
 }
 
@@ -190,36 +717,44 @@ int CacheFS_open(const char *pathname)
 	if (found == std::string::npos || found > 0)
 		return -1;
 
-	// get a unique cache file descriptor
-	int cache_fd = get_unique_cache_fd();
+	std::lock_guard<std::mutex> files_lock(g_files_lock);
 
-	// if file is open, return its file descriptor
-	for (auto fd : fd_path_map)
-		if (strcmp(pathname, fd.second.c_str()) == 0)
+	// if the file is open under any name, share its file descriptor
+	struct stat fi;
+	if (stat(pathname, &fi) != 0)
+		return -1;
+	auto inode_iter = inode_fd_map.find(FileKey{fi.st_dev, fi.st_ino});
+	if (inode_iter == inode_fd_map.end())
+	{
+		// open file, the key is taken again from the open file in case the name was replaced meanwhile
+		int fd = open(pathname, O_RDONLY | O_DIRECT | O_SYNC);
+		if (fd == -1)
+			return -1;
+		if (fstat(fd, &fi) != 0)
 		{
-			cachefd_origfd_map[cache_fd] = fd.first;
-			return cache_fd;
+			close(fd);
+			return -1;
 		}
 
-	// open file
-	int fd = open(pathname, O_RDONLY | O_DIRECT | O_SYNC);
-	if (fd == -1)
-		return -1;
-
-	// initialize file map key
-	try {
-		file_block_map[fd] = new std::set<Block *>;
-	} catch (std::bad_alloc e)
-	{
-		return -1;
+		FileKey key{fi.st_dev, fi.st_ino};
+		inode_iter = inode_fd_map.find(key);
+		if (inode_iter != inode_fd_map.end())
+			close(fd);
+		else
+		{
+			// save file descriptor path, size and key
+			fd_path_map[fd] = pathname;
+			fd_size_map[fd] = fi.st_size;
+			fd_inode_map[fd] = key;
+			fd_refs_map[fd] = 0;
+			inode_iter = inode_fd_map.emplace(key, fd).first;
+		}
 	}
 
-	// save file descriptor path
-	fd_path_map[fd] = pathname;
-	cachefd_origfd_map[cache_fd] = fd;
-	fd_size_map[fd] = get_file_size(pathname);
-	if (fd_size_map[fd] == -1)
-		return -1;
+	// get a unique cache file descriptor
+	int cache_fd = get_unique_cache_fd();
+	cachefd_origfd_map[cache_fd] = inode_iter->second;
+	fd_refs_map[inode_iter->second]++;
 
 	return cache_fd;
 }
@@ -232,6 +767,8 @@ int CacheFS_open(const char *pathname)
  */
 int CacheFS_close(int cache_fd)
 {
+	std::lock_guard<std::mutex> files_lock(g_files_lock);
+
 	// find file in the open files data structure
 	auto file_iter = cachefd_origfd_map.find(cache_fd);
 	if (file_iter == cachefd_origfd_map.end())
@@ -239,74 +776,338 @@ int CacheFS_close(int cache_fd)
 
 	int orig_fd = file_iter->second;
 	cachefd_origfd_map.erase(file_iter);
+	cachefd_readahead_map.erase(cache_fd);
 
 	// if multiple instances of the same file exist, return
-	for (auto fd : cachefd_origfd_map)
-		if (fd.second == orig_fd)
-			return 0;
+	auto refs_iter = fd_refs_map.find(orig_fd);
+	if (--refs_iter->second > 0)
+		return 0;
+	fd_refs_map.erase(refs_iter);
+
+	// remove file from data structures, the file descriptor might be reused by the next open
+	// the blocks are removed first, since background reads of the file might be still in flight
+	remove_file_blocks(orig_fd);
+	fd_path_map.erase(orig_fd);
+	fd_size_map.erase(orig_fd);
+	inode_fd_map.erase(fd_inode_map.at(orig_fd));
+	fd_inode_map.erase(orig_fd);
 
 	// close file
 	int ret = close(orig_fd);
 	if (ret == -1)
 		return -1;
 
-	// remove file from data structures
-	auto file_i = file_block_map.find(orig_fd);
-	delete file_i->second;	// delete the file block set
-	file_block_map.erase(file_i);	// remove file descriptor from open files data structure
-
 	return 0;
 }
 
 int CacheFS_pread(int file_id, void *buf, size_t count, off_t offset)
+{
+	struct iovec output;
+	output.iov_base = buf;
+	output.iov_len = count;
+	return read_file(file_id, &output, 1, count, offset);
+}
+
+/**
+ * Reads data from an open file into several buffers
+ * @param file_id cache file descriptor
+ * @param iov the output buffers, filled in order
+ * @param iovcnt the number of buffers
+ * @param offset the file offset
+ * @return the number of bytes read if successful, otherwise -1.
+ */
+int CacheFS_preadv(int file_id, const struct iovec* iov, int iovcnt, off_t offset)
+{
+	if (iovcnt < 0 || iovcnt > IOV_MAX || (iov == nullptr && iovcnt > 0))
+		return -1;
+
+	// the buffers are a single range of the file
+	size_t count = 0;
+	for (int i = 0; i < iovcnt; ++i)
+		count += iov[i].iov_len;
+
+	return read_file(file_id, iov, iovcnt, count, offset);
+}
+
+/**
+ * Reads several ranges, possibly of different files, accessing each block once
+ * The block accesses of all the requests are sorted by file and block number, so consecutive
+ * missing blocks are read together even if they belong to different requests. The blocks are
+ * pinned until the outputs are filled, when there is no room for more pinned blocks the outputs
+ * of the pinned blocks are filled and the rest of the blocks are read afterwards.
+ * @param reads the read requests, the result of each request is set like the return value of CacheFS_pread
+ * @param reads_num the number of requests
+ * @return 0 if all the requests were successful, otherwise -1.
+ */
+int CacheFS_pread_batch(cachefs_read_t* reads, int reads_num)
+{
+	if (reads_num < 0 || (reads == nullptr && reads_num > 0))
+		return -1;
+
+	std::vector<ReadOutput> outputs(reads_num);
+	std::vector<struct iovec> buffers(reads_num);
+	std::vector<bool> failed(reads_num, false);
+	std::vector<BatchAccess> accesses;
+
+	// find the blocks of every request
+	{
+		std::lock_guard<std::mutex> files_lock(g_files_lock);
+		for (int i = 0; i < reads_num; ++i)
+		{
+			auto elem = cachefd_origfd_map.find(reads[i].file_id);
+			if (reads[i].offset < 0 || elem == cachefd_origfd_map.end())
+			{
+				failed[i] = true;
+				continue;
+			}
+			int orig_fd = elem->second;
+			off_t file_size = fd_size_map[orig_fd];
+
+			buffers[i].iov_base = reads[i].buf;
+			buffers[i].iov_len = reads[i].count;
+			outputs[i].offset = reads[i].offset;
+			outputs[i].count = reads[i].count;
+			outputs[i].buffers = &buffers[i];
+			outputs[i].buffers_num = 1;
+
+			// the same blocks CacheFS_pread accesses
+			off_t end = reads[i].offset + reads[i].count;
+			for (int block_num = reads[i].offset/BLOCK_SIZE; block_num <= end/BLOCK_SIZE; ++block_num)
+			{
+				off_t block_start = (off_t)block_num*BLOCK_SIZE;
+				if (block_start > file_size || block_start >= end)
+					break;
+				accesses.push_back({orig_fd, block_num, i});
+			}
+		}
+	}
+	std::sort(accesses.begin(), accesses.end());
+
+	MissRun run;
+	run.fd = -1;
+	std::vector<std::pair<size_t, Block*>> pinned;
+	size_t next = 0;
+	while (next < accesses.size())
+	{
+		// access and pin the blocks in order, each block once
+		pinned.clear();
+		size_t pos = next;
+		while (pos < accesses.size())
+		{
+			int fd = accesses[pos].fd;
+			int block_num = accesses[pos].block_num;
+			Shard& shard = get_shard(fd, block_num);
+			std::unique_lock<std::mutex> lock(shard.lock);
+			Block* block_p = g_engine.get_block(shard, lock, fd, block_num, run);
+
+			// all the blocks that could make room are pinned by this batch, fill the outputs first
+			if (block_p == nullptr && !pinned.empty())
+				break;
+
+			size_t block_end = pos;
+			while (block_end < accesses.size() && accesses[block_end].fd == fd && accesses[block_end].block_num == block_num)
+				block_end++;
+			if (block_p == nullptr)
+			{
+				for (size_t i = pos; i < block_end; ++i)
+					failed[accesses[i].request] = true;
+				pos = block_end;
+				continue;
+			}
+			block_p->pin_count++;
+			pinned.push_back(std::make_pair(pos, block_p));
+			pos = block_end;
+
+			if (block_p->loading)
+			{
+				lock.unlock();
+				if (run.fd != fd)
+				{
+					run_flush(run);
+					run.fd = fd;
+				}
+				run_add(run, block_p);
+			}
+		}
+		run_flush(run);
+
+		// fill the outputs and unpin the blocks
+		for (auto& block : pinned)
+		{
+			Block* block_p = block.second;
+			Shard& shard = get_shard(block_p->file_id, block_p->block_num);
+			std::lock_guard<std::mutex> lock(shard.lock);
+			for (size_t i = block.first; i < pos && accesses[i].fd == block_p->file_id &&
+										 accesses[i].block_num == block_p->block_num; ++i)
+			{
+				int request = accesses[i].request;
+				if (block_p->data_size == -1)
+					failed[request] = true;
+				else
+					outputs[request].copied += copy_block_data(*block_p, outputs[request]);
+			}
+			block_p->pin_count--;
+		}
+		next = pos;
+	}
+
+	bool all_successful = true;
+	for (int i = 0; i < reads_num; ++i)
+	{
+		reads[i].result = failed[i] ? -1 : (int)outputs[i].copied;
+		if (failed[i])
+			all_successful = false;
+	}
+	return all_successful ? 0 : -1;
+}
+
+/**
+ * Starts reading a range of a file into the cache without waiting for it
+ * @param file_id cache file descriptor
+ * @param offset the range offset
+ * @param count the range size
+ * @return 0 if successful, otherwise -1.
+ */
+int CacheFS_prefetch(int file_id, off_t offset, size_t count)
 {
 	if (offset < 0)
 		return -1;
 
 	// check that the file was opened
-	auto elem = cachefd_origfd_map.find(file_id);
-	if (elem == cachefd_origfd_map.end())
-		return -1;
+	int orig_fd;
+	off_t file_size;
+	{
+		std::lock_guard<std::mutex> files_lock(g_files_lock);
+		auto elem = cachefd_origfd_map.find(file_id);
+		if (elem == cachefd_origfd_map.end())
+			return -1;
+		orig_fd = elem->second;
+		file_size = fd_size_map[orig_fd];
+	}
 
 	if (count == 0)
 		return 0;
 
-	// calculate first and last block ID numbers
-	int first_block_num = (offset/BLOCK_SIZE);
-	int last_block_num = ((offset + count)/BLOCK_SIZE);
+	// a range bigger than a shard would evict its own first blocks
+	count = std::min(count, (size_t)pShards[g_shards_num - 1].capacity*BLOCK_SIZE - offset%BLOCK_SIZE);
+
+	// there is no output buffer, the blocks that aren't read in the background are only read into the cache
+	MissRun run;
+	run.fd = orig_fd;
+
+	prefetch_range(orig_fd, file_size, offset/BLOCK_SIZE, (offset + count - 1)/BLOCK_SIZE + 1, run);
+	run_flush(run);
+
+	return 0;
+}
+
+/**
+ * Returns read only views of the cached data of a range, the blocks are pinned until they are released
+ * @param file_id cache file descriptor
+ * @param views the output views, one per block
+ * @param max_views the max number of views
+ * @param count the range size
+ * @param offset the range offset
+ * @return the number of views if successful, otherwise -1.
+ */
+int CacheFS_pread_ref(int file_id, cachefs_view_t* views, int max_views, size_t count, off_t offset)
+{
+	if (offset < 0 || views == nullptr || max_views < 0)
+		return -1;
+
+	// check that the file was opened
+	int orig_fd;
+	off_t file_size;
+	{
+		std::lock_guard<std::mutex> files_lock(g_files_lock);
+		auto elem = cachefd_origfd_map.find(file_id);
+		if (elem == cachefd_origfd_map.end())
+			return -1;
+		orig_fd = elem->second;
+		file_size = fd_size_map[orig_fd];
+	}
 
-	size_t pos, out_index = 0;
-	int block_num, buffer_index, orig_fd = cachefd_origfd_map[file_id];
-	char* output_buffer = (char*) buf;
+	// the missing blocks are read into the cache, nothing is copied
+	MissRun run;
+	run.fd = orig_fd;
+
+	int views_num = 0;
+	int block_num;
+	off_t block_start;
 	Block* block_p;
 
-	// iterate over blocks and read data
-	for (block_num = first_block_num; block_num <= last_block_num && out_index < count; ++block_num)
+	// pin the blocks, a pinned block that is still loading is read with the rest of the run
+	for (block_num = offset/BLOCK_SIZE; views_num < max_views; ++block_num)
 	{
-		// out of file bounds check
-		if (block_num*BLOCK_SIZE > fd_size_map[orig_fd])
+		block_start = (off_t)block_num*BLOCK_SIZE;
+		if (block_start >= file_size || block_start >= (off_t)(offset + count))
 			break;
 
-		// get block pointer
-		block_p = get_block(orig_fd, block_num);
-		if (block_p == nullptr || block_p->data_size == -1)
-			return -1;
+		Shard& shard = get_shard(orig_fd, block_num);
+		std::unique_lock<std::mutex> lock(shard.lock);
+		block_p = g_engine.get_block(shard, lock, orig_fd, block_num, run);
+		if (block_p == nullptr)
+		{
+			run.failed = true;
+			break;
+		}
+		block_p->pin_count++;
+		views[views_num].block_id = block_p->id;
+		views_num++;
 
-		// read data (min(block_size, buffer_data_size) bytes) from block buffer
-		for (buffer_index = 0; buffer_index < BLOCK_SIZE && buffer_index < block_p->data_size; ++buffer_index)
+		if (block_p->loading)
 		{
-			pos = (block_num*BLOCK_SIZE) + buffer_index;
-			if (pos >= (size_t)offset && pos < offset + count)
-			{
-				output_buffer[out_index++] = ((char*)block_p->buffer)[buffer_index];
-			}
+			lock.unlock();
+			run_add(run, block_p);
 		}
+	}
+	run_flush(run);
 
-		// update block queue
-		update_queue(block_p);
+	// a pinned block can't change, so its data is read without the lock
+	for (int i = 0; i < views_num && !run.failed; ++i)
+	{
+		block_p = pBlockArray[views[i].block_id];
+		if (block_p->data_size == -1)
+		{
+			run.failed = true;
+			break;
+		}
+		block_start = (off_t)block_p->block_num*BLOCK_SIZE;
+		off_t view_start = std::max(offset, block_start);
+		off_t view_end = std::min((off_t)(offset + count), block_start + block_p->data_size);
+		views[i].data = (char*)block_p->buffer + (view_start - block_start);
+		views[i].size = (view_end > view_start) ? view_end - view_start : 0;
 	}
 
-	return out_index;
+	if (run.failed)
+	{
+		CacheFS_release(views, views_num);
+		return -1;
+	}
+	return views_num;
+}
+
+/**
+ * Releases views that were returned by CacheFS_pread_ref, the blocks can be evicted again
+ * @param views the views to release
+ * @param views_num the number of views
+ * @return 0 if successful, otherwise -1.
+ */
+int CacheFS_release(cachefs_view_t* views, int views_num)
+{
+	if (views == nullptr && views_num > 0)
+		return -1;
+
+	for (int i = 0; i < views_num; ++i)
+	{
+		Shard& shard = get_id_shard(views[i].block_id);
+		std::lock_guard<std::mutex> lock(shard.lock);
+		pBlockArray[views[i].block_id]->pin_count--;
+		views[i].data = nullptr;
+		views[i].size = 0;
+	}
+
+	return 0;
 }
 
 /**
@@ -321,20 +1122,20 @@ int CacheFS_print_cache (const char *log_path)
 	if (log_fd == -1)
 		return -1;
 
-	std::string log_line = "";
-	Block* block_p;
+	std::lock_guard<std::mutex> files_lock(g_files_lock);
 
-	// iterate over the block queue from the end
-	for (int i = block_queue.size()-1; i >= 0; --i)
+	// each shard runs the cache algorithm on its own blocks, print the shards one after the other
+	// prefetched blocks that weren't accessed yet aren't printed
+	std::vector<int> order;
+	for (int i = 0; i < g_shards_num; ++i)
 	{
-		block_p = pBlockArray[block_queue[i]];
-		// create string
-		log_line += fd_path_map[block_p->file_id] + " " + std::to_string(block_p->block_num) + "\n";
-		ssize_t ret = write(log_fd, log_line.c_str(), log_line.length());
-		if (ret == -1)
-			return -1;
-
-		log_line = "";	// reset string
+		Shard& shard = pShards[i];
+		std::lock_guard<std::mutex> lock(shard.lock);
+		order.clear();
+		shard.policy->order(order);
+		for (int id : order)
+			if (!pBlockArray[id]->prefetched && print_block(log_fd, *pBlockArray[id]) == -1)
+				return -1;
 	}
 	int close_ret = close(log_fd);
 	return close_ret;
@@ -352,9 +1153,24 @@ int CacheFS_print_stat (const char *log_path)
 	if (log_fd == -1)
 		return -1;
 
-	// generate log string
-	std::string log_str = HITS_LOG(g_hit_counter);
-	log_str += MISSES_LOG(g_miss_counter);
+	// sum the shards counters
+	size_t hit_counter = 0, miss_counter = 0;
+	size_t prefetch_counter = 0, prefetch_hit_counter = 0, prefetch_wasted_counter = 0;
+	for (int i = 0; i < g_shards_num; ++i)
+	{
+		std::lock_guard<std::mutex> lock(pShards[i].lock);
+		hit_counter += pShards[i].hit_counter + pShards[i].unlocked_hit_counter;
+		miss_counter += pShards[i].miss_counter;
+		prefetch_counter += pShards[i].prefetch_counter;
+		prefetch_hit_counter += pShards[i].prefetch_hit_counter;
+		prefetch_wasted_counter += pShards[i].prefetch_wasted_counter;
+	}
+
+	// generate log string, the prefetch statistics are printed only when blocks can be prefetched
+	std::string log_str = HITS_LOG(hit_counter);
+	log_str += MISSES_LOG(miss_counter);
+	if (g_readahead_max > 0 || prefetch_counter > 0)
+		log_str += PREFETCH_LOG(prefetch_counter, prefetch_hit_counter, prefetch_wasted_counter);
 
 	ssize_t ret = write(log_fd, log_str.c_str(), log_str.length());
 	if (ret == -1)
@@ -381,277 +1197,732 @@ static blksize_t get_block_size()
 }
 
 /**
- * Creates a new block
+ * Returns the shard a block belongs to
+ * The block index pages of a file are dealt to the shards in turn, starting at a shard that depends on the file,
+ * so all the blocks of a page belong to the same shard
  * @param fd file descriptor
  * @param block_num the number of the block
- * @return pointer to a new block, nullptr when failed
+ * @return the block shard
  */
-static Block* create_block(int fd, int block_num)
+static Shard& get_shard(int fd, int block_num)
 {
-	Block * new_block;
+	uint32_t page = (uint32_t)block_num >> BLOCK_INDEX_PAGE_SHIFT;
+	return pShards[(page + (uint32_t)fd) & (g_shards_num - 1)];
+}
 
-	make_room();
-	int id = get_free_id();
+/**
+ * Returns the cache engine functions of a cache algorithm
+ * @return the engine functions, instantiated for the algorithm class
+ */
+template <class Policy>
+static CacheEngine engine_for()
+{
+	CacheEngine engine;
+	engine.create_policy = create_policy<Policy>;
+	engine.get_block = get_block<Policy>;
+	engine.prefetch_block = prefetch_block<Policy>;
+	engine.remove_block = remove_block<Policy>;
+	engine.update_miss_cost = update_miss_cost<Policy>;
+	engine.read_unlocked = Policy::UNLOCKED_ACCESS ? read_unlocked<Policy> : nullptr;
+	return engine;
+}
 
-	// create new block
-	try
-	{
-		new_block = new Block(fd, block_num, BLOCK_SIZE, id);
-	} catch (std::bad_alloc e)
+/**
+ * Creates the cache algorithm object of a shard
+ * @param config the algorithm parameters
+ * @return the new algorithm object, nullptr when failed
+ */
+template <class Policy>
+static CachePolicy* create_policy(const PolicyConfig& config)
+{
+	Policy* policy = new (std::nothrow) Policy(pBlockPool);
+	if (policy == nullptr)
+		return nullptr;
+	if (policy->init(config) == -1)
 	{
+		delete policy;
 		return nullptr;
 	}
+	return policy;
+}
+
+/**
+ * Creates a new block
+ * The block is marked as loading until its data is read from the file by run_flush,
+ * so other threads wait for it instead of reading it again or evicting it
+ * @param shard the block shard, must have a free block id
+ * @param fd file descriptor
+ * @param block_num the number of the block
+ * @param prefetched true if the block is read by readahead or CacheFS_prefetch, not by a demand access
+ * @return pointer to a new block, nullptr when failed
+ */
+template <class Policy>
+static Block* create_block(Shard& shard, int fd, int block_num, bool prefetched)
+{
+	int id = get_free_id(shard);
+	if (id == -1)
+		return nullptr;
 
-	// add new block to data structures
+	shard.block_index.insert(fd, block_num, id);
+
+	// add the pool block with the same id to data structures
+	Block* new_block = &pBlockPool[id];
+	new_block->reset(fd, block_num);
+	new_block->loading = true;
+	new_block->prefetched = prefetched;
+	if (Policy::USES_COST)
+	{
+		// the block costs the average read time of its file, or 1 before a block of the file was timed
+		auto latency_iter = shard.miss_latency.find(fd);
+		double cost = latency_iter != shard.miss_latency.end() ? latency_iter->second : 1;
+		static_cast<Policy*>(shard.policy)->cost_changed(*new_block, cost);
+	}
 	pBlockArray[id] = new_block;
-	file_block_map[fd]->insert(new_block);
+	static_cast<Policy*>(shard.policy)->insert(*new_block);
+
+	// increase shard block counter
+	shard.blocks_counter++;
 
-	// increase global block counter
-	g_blocks_counter++;
 	return new_block;
 }
 
 /**
- * Update the position of the given block in the LRU queue
- * @param block_p pointer to a block
+ * Makes room in the shard according to the cache algorithm if needed.
+ * Pinned blocks are skipped by the algorithms. Blocks that are still loading can't be evicted,
+ * if the algorithm chooses one, waits until it's loaded
+ * @param shard the shard to make room in
+ * @param lock the locked shard lock
+ * @param run the calling thread pending run
+ * @return 0 if the shard has room, 1 if the lock was released while waiting for a block to load,
+ * then the caller should check the shard state again, -1 if all the shard blocks are pinned.
  */
-static void LRU_update_queue(Block& block)
+template <class Policy>
+static int make_room(Shard& shard, std::unique_lock<std::mutex>& lock, MissRun& run)
 {
-	// remove block from queue
-	auto block_iter = std::find(block_queue.begin(), block_queue.end(), block.id);
-	if (block_iter != block_queue.end())
-		block_queue.erase(block_iter);
+	Policy& policy = *static_cast<Policy*>(shard.policy);
+	while (shard.blocks_counter >= shard.capacity)
+	{
+		int block_id = policy.victim();
+		if (block_id == -1)
+			return -1;
+		if (pBlockArray[block_id]->loading)
+		{
+			wait_for_block(shard, lock, run);
+			return 1;
+		}
+		remove_block<Policy>(shard, block_id);
+	}
+	return 0;
+}
 
-	// add it to the back of the queue
-	block_queue.push_back(block.id);
+/**
+ * Returns an unused block id
+ * id = free cell in the block array
+ * @param shard the shard to take the id from
+ * @return unique block id, -1 if failed
+ */
+static int get_free_id(Shard& shard)
+{
+	if (shard.free_ids.empty())
+		return -1;
+	int id = shard.free_ids.back();
+	shard.free_ids.pop_back();
+	return id;
 }
 
 /**
- * Adds the given block to the block_queue if it's not there
- * @param block the block to add to the block_queue
+ * Returns a pointer to the requested block and updates the cache algorithm
+ * Creates it if needed, a new block is returned while it's still loading
+ * @param shard the block shard
+ * @param lock the locked shard lock, might be released while waiting, and locked again on return
+ * @param fd file descriptor
+ * @param block_num the number of the block
+ * @param run the calling thread pending run
+ * @return pointer to the requested block, nullptr when failed
  */
-static void LFU_update_queue(Block& block)
+template <class Policy>
+static Block* get_block(Shard& shard, std::unique_lock<std::mutex>& lock, int fd, int block_num, MissRun& run)
 {
-	block.reference_num++;
+	Block* block_p;
 
-	// remove block from queue
-	auto block_iter = std::find(block_queue.begin(), block_queue.end(), block.id);
-	if (block_iter != block_queue.end())
-		block_queue.erase(block_iter);
+	while (true)
+	{
+		// find block if exists
+		int block_id = shard.block_index.find(fd, block_num);
 
-	// find first block with reference count higher than this block
-	block_iter = std::find_if(block_queue.begin(), block_queue.end(), [&block](int& id)->bool{
-		return pBlockArray[id]->reference_num > block.reference_num;
-	});
+		if (block_id != -1)
+		{
+			// another thread is reading the block, wait for it
+			block_p = pBlockArray[block_id];
+			if (block_p->loading)
+			{
+				wait_for_block(shard, lock, run);
+				continue;
+			}
 
-	// if this block has the highest reference count, insert it to the end of the queue
-	// otherwise insert it before the a block with a higher reference count
-	if (block_iter == block_queue.end())
-		block_queue.push_back(block.id);
-	else
-		block_queue.insert(block_iter, block.id);
+			// block exists, return it, the first access to a prefetched block is a prefetch hit
+			if (block_p->prefetched)
+			{
+				block_p->prefetched = false;
+				if (Policy::UNLOCKED_ACCESS)
+					shard.read_guards[block_id - shard.first_id].publish(*block_p);
+				shard.prefetch_hit_counter++;
+			}
+			else
+				shard.hit_counter++;
+			static_cast<Policy*>(shard.policy)->access(*block_p);
+			return block_p;
+		}
+
+		// block doesn't exist, create it once there is room for it
+		int room = make_room<Policy>(shard, lock, run);
+		if (room == 1)
+			continue;
+		if (room == -1)
+			return nullptr;
+		shard.miss_counter++;
+		return create_block<Policy>(shard, fd, block_num, false);
+	}
 }
 
 /**
- * Updates the blocks queue and the block reference counter according to the FBR algorithm
- * @param block_p block object pointer
+ * Copies a cached block to the output buffers and updates the cache algorithm without taking the shard lock,
+ * for the algorithms with UNLOCKED_ACCESS
+ * The block is found by an unlocked index probe and counted as a reader, then it's checked to be the published
+ * requested block, so it isn't removed or reused until the reader leaves
+ * @param shard the block shard
+ * @param fd file descriptor
+ * @param block_num the number of the block
+ * @param output the requested range and the output buffers
+ * @return true if the block was copied, false if the block isn't published and the shard lock must be taken
  */
-static void FBR_update_queue(Block* block_p)
+template <class Policy>
+static bool read_unlocked(Shard& shard, int fd, int block_num, ReadOutput& output)
 {
-	// update references number only in blocks not in the new partition
-	if (!FBR_block_is_new(*block_p))
-		block_p->reference_num++;
+	int block_id = shard.block_index.find_unlocked(fd, block_num);
+	if (block_id == -1)
+		return false;
 
-	// update the queue according to the LRU algorithm
-	LRU_update_queue(*block_p);
+	ReadGuard& guard = shard.read_guards[block_id - shard.first_id];
+	if (!guard.read_begin(fd, block_num))
+		return false;
+	Block& block = pBlockPool[block_id];
+	output.copied += copy_block_data(block, output);
+	static_cast<Policy*>(shard.policy)->access(block);
+	guard.read_end();
+
+	shard.unlocked_hit_counter.fetch_add(1, std::memory_order_relaxed);
+	return true;
 }
 
 /**
- * Returns true if the given block is in the new partition
- * @param block a block object
- * @return true if the block is in the new partition, otherwise false.
+ * Reads a range of an open file into the output buffers, each block of the range is accessed once
+ * @param file_id cache file descriptor
+ * @param iov the output buffers, filled in order
+ * @param iovcnt the number of buffers
+ * @param count the range size, the total size of the buffers
+ * @param offset the range offset
+ * @return the number of bytes read if successful, otherwise -1.
  */
-static bool FBR_block_is_new(Block& block)
+static int read_file(int file_id, const struct iovec* iov, int iovcnt, size_t count, off_t offset)
 {
-	size_t i;
-	// find block index in block queue
-	for (i = 0; i < block_queue.size() && block.id != block_queue[i]; ++i)
-		;
+	if (offset < 0)
+		return -1;
 
-	// block isn't in the block queue => not in new partition
-	if (i == block_queue.size())
-		return false;
+	// check that the file was opened
+	int orig_fd;
+	off_t file_size;
+	int prefetched_first = 0, prefetched_end = 0;
+	{
+		std::lock_guard<std::mutex> files_lock(g_files_lock);
+		auto elem = cachefd_origfd_map.find(file_id);
+		if (elem == cachefd_origfd_map.end())
+			return -1;
+		orig_fd = elem->second;
+		file_size = fd_size_map[orig_fd];
+
+		// the blocks the file stream already prefetched
+		auto state = cachefd_readahead_map.find(file_id);
+		if (state != cachefd_readahead_map.end() && state->second.window > 0)
+		{
+			prefetched_first = state->second.first_block;
+			prefetched_end = state->second.next_block;
+		}
+	}
+
+	if (count == 0)
+		return 0;
+
+	// calculate first and last block ID numbers
+	int first_block_num = (offset/BLOCK_SIZE);
+	int last_block_num = ((offset + count)/BLOCK_SIZE);
+
+	ReadOutput output;
+	output.offset = offset;
+	output.count = count;
+	output.buffers = iov;
+	output.buffers_num = iovcnt;
+
+	MissRun run;
+	run.fd = orig_fd;
+	run.output = &output;
+
+	int block_num;
+	off_t block_start;
+	Block* block_p;
+	bool wasted = false;
 
-	// The new blocks are at the end of the queue
-	// This calculates the block position in percentage from the end of the queue
-	// last element = 0.0, first element = 1.0
-	double pos = ((double)(block_queue.size() - (i + 1)))/block_queue.size();
+	// iterate over blocks and read data
+	for (block_num = first_block_num; block_num <= last_block_num; ++block_num)
+	{
+		// out of file bounds check
+		block_start = (off_t)block_num*BLOCK_SIZE;
+		if (block_start > file_size || block_start >= (off_t)(offset + count))
+			break;
+
+		// a hit of an algorithm that reads blocks without the shard lock is done here
+		Shard& shard = get_shard(orig_fd, block_num);
+		if (g_engine.read_unlocked != nullptr && g_engine.read_unlocked(shard, orig_fd, block_num, output))
+			continue;
+
+		// get block pointer, the block can't be evicted while its shard is locked
+		std::unique_lock<std::mutex> lock(shard.lock);
+		block_p = g_engine.get_block(shard, lock, orig_fd, block_num, run);
+		if (block_p == nullptr)
+		{
+			run.failed = true;
+			break;
+		}
+
+		// a new block is still loading, it's read from the file with the rest of the run
+		if (block_p->loading)
+		{
+			// a prefetched block was removed before it was used, the readahead window is too big
+			if (block_num >= prefetched_first && block_num < prefetched_end)
+				wasted = true;
+			lock.unlock();
+			run_add(run, block_p);
+			continue;
+		}
 
-	return (pos <= PART_NEW);
+		if (block_p->data_size == -1)
+		{
+			run.failed = true;
+			break;
+		}
+		output.copied += copy_block_data(*block_p, output);
+	}
+
+	// prefetch the next blocks of a sequential stream
+	int first_block = 0, last_block = 0;
+	if (g_readahead_max > 0 && !run.failed)
+	{
+		std::lock_guard<std::mutex> files_lock(g_files_lock);
+		if (cachefd_origfd_map.count(file_id) == 1)
+			readahead_update(cachefd_readahead_map[file_id], offset, count, wasted, first_block, last_block);
+	}
+	prefetch_range(orig_fd, file_size, first_block, last_block, run);
+
+	// read the remaining missing blocks
+	run_flush(run);
+
+	if (run.failed)
+		return -1;
+	return output.copied;
 }
 
 /**
- * Makes room in the cache according to the cache algorithm in the cache data structure if needed.
+ * Adds the requested block to the cache as a prefetched block if it isn't cached
+ * @param shard the block shard
+ * @param lock the locked shard lock, might be released while waiting, and locked again on return
+ * @param fd file descriptor
+ * @param block_num the number of the block
+ * @param run the calling thread pending run
+ * @return pointer to the new loading block, nullptr if the block is already cached or when failed
  */
-static void make_room()
+template <class Policy>
+static Block* prefetch_block(Shard& shard, std::unique_lock<std::mutex>& lock, int fd, int block_num, MissRun& run)
 {
-	if (g_blocks_counter < MAX_BLOCKS)
-		return;
+	int room;
+	do
+	{
+		if (shard.block_index.find(fd, block_num) != -1)
+			return nullptr;
+		room = make_room<Policy>(shard, lock, run);
+	} while (room == 1);
+	if (room == -1)
+		return nullptr;
 
-	if (CACHE_ALGO == LRU)
-		LRU_make_room();
-	else if (CACHE_ALGO == LFU)
-		LFU_make_room();
-	else if (CACHE_ALGO == FBR)
-		FBR_make_room();
+	Block* block_p = create_block<Policy>(shard, fd, block_num, true);
+	if (block_p == nullptr)
+		return nullptr;
+	shard.prefetch_counter++;
+	return block_p;
 }
 
 /**
- * Removes the least recently used block
+ * Adds the uncached blocks of a range to the cache as prefetched blocks
+ * The blocks are read in the background, when the background reads engine is inactive or full
+ * they are added to the pending run instead
+ * Must be called without holding a shard lock
+ * @param fd file descriptor
+ * @param file_size the file size, blocks after the end of the file aren't prefetched
+ * @param first_block the first block of the range
+ * @param last_block the block after the last block of the range
+ * @param run the calling thread pending run
  */
-static void LRU_make_room()
+static void prefetch_range(int fd, off_t file_size, int first_block, int last_block, MissRun& run)
 {
-	// get block id to remove
-	int block_id = block_queue.front();
-	remove_block(block_id);
+	PrefetchRun*& prefetch = run.prefetch;
+	Block* block_p;
+
+	for (int block_num = first_block; block_num < last_block; ++block_num)
+	{
+		if ((off_t)block_num*BLOCK_SIZE >= file_size)
+			break;
+
+		Shard& shard = get_shard(fd, block_num);
+		std::unique_lock<std::mutex> lock(shard.lock);
+		block_p = g_engine.prefetch_block(shard, lock, fd, block_num, run);
+		lock.unlock();
+
+		// an already cached block ends the background read
+		if (block_p == nullptr || (prefetch != nullptr && prefetch->size == MAX_RUN_BLOCKS))
+			prefetch_submit(prefetch, run);
+		if (block_p == nullptr)
+			continue;
+		if (!g_io_engine.active())
+		{
+			run_add(run, block_p);
+			continue;
+		}
+
+		if (prefetch == nullptr)
+		{
+			prefetch = new (std::nothrow) PrefetchRun;
+			if (prefetch == nullptr)
+			{
+				run_add(run, block_p);
+				continue;
+			}
+			prefetch->fd = fd;
+		}
+		prefetch->blocks[prefetch->size] = block_p;
+		prefetch->iov[prefetch->size].iov_base = block_p->buffer;
+		prefetch->iov[prefetch->size].iov_len = BLOCK_SIZE;
+		prefetch->size++;
+	}
+
+	prefetch_submit(prefetch, run);
 }
 
 /**
- * Remove the least frequently used block
+ * Starts the background read of a prefetch run, the read is submitted right away since the thread
+ * may wait for a block of the shard before it reaches the end of the range
+ * When the background reads engine is inactive or full, the blocks are added to the pending run instead
+ * Must be called without holding a shard lock
+ * @param prefetch the prefetch run, owned by the engine afterwards, set to nullptr
+ * @param run the calling thread pending run
  */
-static void LFU_make_room()
+static void prefetch_submit(PrefetchRun*& prefetch, MissRun& run)
 {
-	// get block to remove
-	int block_id = block_queue.front();
-	remove_block(block_id);
+	if (prefetch == nullptr)
+		return;
+
+	off_t offset = (off_t)prefetch->blocks[0]->block_num*BLOCK_SIZE;
+	prefetch->start = std::chrono::steady_clock::now();
+	if (!g_io_engine.queue_read(prefetch->fd, prefetch->iov, prefetch->size, offset, (uint64_t)(uintptr_t)prefetch))
+	{
+		for (int i = 0; i < prefetch->size; ++i)
+			run_add(run, prefetch->blocks[i]);
+		delete prefetch;
+	}
+	else
+		g_io_engine.submit();
+	prefetch = nullptr;
 }
 
 /**
- * Removes the block with the lowest reference count in the old partition
+ * Completes a background read of a prefetch run, called by the background reads engine
+ * Blocks that failed to load are removed, so a demand access reads them again, the cost of the other blocks
+ * is updated with the time since the read was queued
+ * @param tag the prefetch run
+ * @param result the number of bytes read, -1 if the read failed
  */
-static void FBR_make_room()
+static void prefetch_done(uint64_t tag, ssize_t result)
 {
-	size_t min_ref, new_ref, i;
-	// set the initial min reference number
-	int min_block_id = block_queue[0];
-	min_ref = pBlockArray[min_block_id]->reference_num;
-	// iterate over the old partition and find the block with the min reference number
-	// the old partition is block_queue[0] up to block_queue[block_queue.size()*PART_OLD]
-	for (i = 1 ; ((double)(i + 1))/block_queue.size() <= PART_OLD && i < block_queue.size(); ++i)
+	PrefetchRun* prefetch = (PrefetchRun*)(uintptr_t)tag;
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - prefetch->start;
+	double block_latency = elapsed.count()/prefetch->size;
+
+	for (int i = 0; i < prefetch->size; ++i)
 	{
-		new_ref = pBlockArray[block_queue[i]]->reference_num;
-		if (new_ref < min_ref)
-		{
-			min_ref = new_ref;
-			min_block_id = block_queue[i];
-		}
+		Block* block_p = prefetch->blocks[i];
+		Shard& shard = get_shard(prefetch->fd, block_p->block_num);
+		std::lock_guard<std::mutex> lock(shard.lock);
+
+		// a short read ends in the last block of the file
+		if (result == -1)
+			block_p->data_size = -1;
+		else
+			block_p->data_size = std::min(std::max(result - (ssize_t)i*BLOCK_SIZE, (ssize_t)0), (ssize_t)BLOCK_SIZE);
+		block_p->loading = false;
+		if (block_p->data_size == -1)
+			g_engine.remove_block(shard, block_p->id);
+		else
+			g_engine.update_miss_cost(shard, block_p, block_latency);
+		shard.block_loaded.notify_all();
 	}
 
-	remove_block(min_block_id);
+	delete prefetch;
 }
 
 /**
- * Returns an unused block id
- * id = free cell in the block array
- * @return unique block id, -1 if failed
+ * Updates the sequential access detector of a file with a read and returns the blocks to prefetch
+ * The window starts at INITIAL_READAHEAD_BLOCKS on the second sequential read, and doubles up to
+ * g_readahead_max whenever a read reaches the last prefetched window. It's halved when prefetched
+ * blocks were removed before they were read
+ * @param state the file readahead state
+ * @param offset the read offset
+ * @param count the read size
+ * @param wasted true if the read missed blocks that were prefetched
+ * @param first_block set to the first block to prefetch
+ * @param last_block set to the block after the last block to prefetch
  */
-static int get_free_id()
+static void readahead_update(ReadaheadState& state, off_t offset, size_t count, bool wasted,
+							 int& first_block, int& last_block)
 {
-	int i;
-	for (i = 0; i < MAX_BLOCKS; ++i)
-		if (pBlockArray[i] == nullptr)
-			break;
-	return i;
+	bool sequential = (offset == state.next_offset);
+	int last_read_block = (offset + count - 1)/BLOCK_SIZE;
+	state.next_offset = offset + count;
+	first_block = last_block = 0;
+
+	// a random read ends the stream
+	if (!sequential)
+	{
+		state.window = 0;
+		return;
+	}
+
+	if (state.window == 0)
+	{
+		// a new stream
+		state.window = std::min(INITIAL_READAHEAD_BLOCKS, g_readahead_max.load());
+		state.first_block = last_read_block + 1;
+		state.next_block = last_read_block + 1;
+	}
+	else if (wasted)
+		state.window = std::max(state.window/2, 1);
+	else if (last_read_block >= state.marker)
+		state.window = std::min(state.window*2, g_readahead_max.load());
+	else
+		return;
+
+	// prefetch the next window right after the blocks that were read or prefetched
+	state.next_block = std::max(state.next_block, last_read_block + 1);
+	state.marker = state.next_block;
+	first_block = state.next_block;
+	last_block = state.next_block + state.window;
+	state.next_block = last_block;
 }
 
 /**
- * Returns a pointer to the requested block
- * Creates it if needed
- * @param fd file descriptor
- * @param block_num the number of the block
- * @return pointer to the requested block, nullptr when failed
+ * Waits until a loading block of the shard is loaded
+ * A thread with a pending run or prefetch run queues the prefetch run and reads its run instead of waiting,
+ * so a thread never waits while other threads (or its own eviction) wait for its blocks
+ * @param shard the shard of the loading block
+ * @param lock the locked shard lock, locked again on return
+ * @param run the calling thread pending run
  */
-static Block* get_block(int fd, int block_num)
+static void wait_for_block(Shard& shard, std::unique_lock<std::mutex>& lock, MissRun& run)
 {
-	Block* block_p;
-	std::set<Block*>& block_set = *file_block_map[fd];
+	if (run.size == 0 && run.prefetch == nullptr)
+	{
+		shard.block_loaded.wait(lock);
+		return;
+	}
+
+	lock.unlock();
+	prefetch_submit(run.prefetch, run);
+	run_flush(run);
+	lock.lock();
+}
 
-	// find block if exists
-	auto block_iter = std::find_if(block_set.begin(), block_set.end(), [&block_num](Block* const block) {
-		return block->block_num == block_num;
-	});
+/**
+ * Adds a new block to the pending run, the run is read first if the block doesn't continue it
+ * Must be called without holding a shard lock
+ * @param run the pending run
+ * @param block_p a loading block
+ */
+static void run_add(MissRun& run, Block* block_p)
+{
+	if (run.size > 0 && (run.first_block_num + run.size != block_p->block_num || run.size == MAX_RUN_BLOCKS))
+		run_flush(run);
 
-	if (block_iter == block_set.end())
+	if (run.size == 0)
+		run.first_block_num = block_p->block_num;
+	run.blocks[run.size++] = block_p;
+}
+
+/**
+ * Reads all the blocks of the pending run with a single vectored read, marks them as loaded
+ * and copies their data to the output buffer, the algorithms with UNLOCKED_ACCESS can read them without the lock then
+ * Must be called without holding a shard lock
+ * @param run the pending run, empty on return
+ */
+static void run_flush(MissRun& run)
+{
+	if (run.size == 0)
+		return;
+
+	struct iovec iov[MAX_RUN_BLOCKS];
+	for (int i = 0; i < run.size; ++i)
 	{
-		// block doesn't exist, create it
-		g_miss_counter++;
-		block_p = create_block(fd, block_num);	// block doesn't exist, create a new block
+		iov[i].iov_base = run.blocks[i]->buffer;
+		iov[i].iov_len = BLOCK_SIZE;
 	}
-	else
+	auto start = std::chrono::steady_clock::now();
+	ssize_t ret = preadv(run.fd, iov, run.size, (off_t)run.first_block_num*BLOCK_SIZE);
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+	double block_latency = elapsed.count()/run.size;
+
+	for (int i = 0; i < run.size; ++i)
 	{
-		// block exists, return it
-		g_hit_counter++;
-		block_p = *block_iter;
+		Block* block_p = run.blocks[i];
+		Shard& shard = get_shard(run.fd, block_p->block_num);
+		std::lock_guard<std::mutex> lock(shard.lock);
+
+		// a short read ends in the last block of the file, the following blocks are empty
+		if (ret == -1)
+			block_p->data_size = -1;
+		else
+			block_p->data_size = std::min(std::max(ret - (ssize_t)i*BLOCK_SIZE, (ssize_t)0), (ssize_t)BLOCK_SIZE);
+		block_p->loading = false;
+		if (ret != -1)
+			g_engine.update_miss_cost(shard, block_p, block_latency);
+		if (shard.read_guards != nullptr && block_p->data_size != -1 && !block_p->prefetched)
+			shard.read_guards[block_p->id - shard.first_id].publish(*block_p);
+
+		if (block_p->data_size == -1)
+			run.failed = true;
+		else if (run.output != nullptr)
+			run.output->copied += copy_block_data(*block_p, *run.output);
+		shard.block_loaded.notify_all();
 	}
 
-	return block_p;
+	run.size = 0;
 }
 
 /**
- * Update the block queue according to the cache algorithm
- * @param block_p block pointer
+ * Adds a block read time to the moving average of its file in the shard, each time weighs 1/8 of the average,
+ * and the new average becomes the block cost, does nothing for the algorithms that don't use the cost
+ * @param shard the shard of the block, must be locked
+ * @param block_p a block that was just read
+ * @param latency the time in microseconds it took to read the block
  */
-static void update_queue(Block* block_p)
+template <class Policy>
+static void update_miss_cost(Shard& shard, Block* block_p, double latency)
 {
-	// update blocks queue
-	if (CACHE_ALGO == LRU)
-		LRU_update_queue(*block_p);
-	else if (CACHE_ALGO == LFU)
-		LFU_update_queue(*block_p);
-	else if (CACHE_ALGO == FBR)
-		FBR_update_queue(block_p);
+	if (!Policy::USES_COST)
+		return;
+
+	auto latency_iter = shard.miss_latency.find(block_p->file_id);
+	if (latency_iter == shard.miss_latency.end())
+		latency_iter = shard.miss_latency.emplace(block_p->file_id, latency).first;
+	else
+		latency_iter->second += (latency - latency_iter->second)/8;
+	static_cast<Policy*>(shard.policy)->cost_changed(*block_p, latency_iter->second);
+}
+
+/**
+ * Copies the part of the block data that overlaps the requested range to its place in the output buffers
+ * @param block a loaded block
+ * @param output the requested range and the output buffers
+ * @return the number of bytes copied
+ */
+static size_t copy_block_data(const Block& block, ReadOutput& output)
+{
+	// min(block_size, buffer_data_size) bytes of the block
+	off_t block_start = (off_t)block.block_num*BLOCK_SIZE;
+	off_t copy_start = std::max(output.offset, block_start);
+	off_t copy_end = std::min((off_t)(output.offset + output.count), block_start + block.data_size);
+	if (copy_end <= copy_start)
+		return 0;
+
+	// find the output buffer of the first byte
+	size_t position = copy_start - output.offset;
+	if (position < output.buffer_start)
+	{
+		output.buffer_index = 0;
+		output.buffer_start = 0;
+	}
+	while (output.buffer_start + output.buffers[output.buffer_index].iov_len <= position)
+		output.buffer_start += output.buffers[output.buffer_index++].iov_len;
+
+	// scatter the data over the buffers
+	char* data = (char*)block.buffer + (copy_start - block_start);
+	size_t size = copy_end - copy_start;
+	size_t copied = 0;
+	for (int i = output.buffer_index; copied < size; ++i)
+	{
+		size_t buffer_start = (i == output.buffer_index) ? position - output.buffer_start : 0;
+		size_t length = std::min(output.buffers[i].iov_len - buffer_start, size - copied);
+		memcpy((char*)output.buffers[i].iov_base + buffer_start, data + copied, length);
+		copied += length;
+	}
+	return size;
 }
 
 /**
  * Removes the requested block from all the data structures
- * and frees allocated memory
+ * @param shard the block shard
  * @param block_id the block to remove
  */
-static void remove_block(int block_id)
+template <class Policy>
+static void remove_block(Shard& shard, int block_id)
 {
-	// remove block from queue
-	auto block_iter = std::find(block_queue.begin(), block_queue.end(), block_id);
-	block_queue.erase(block_iter);
-
 	Block* block_p = pBlockArray[block_id];
+	if (Policy::UNLOCKED_ACCESS)
+		shard.read_guards[block_id - shard.first_id].unpublish();
+	if (block_p->prefetched)
+		shard.prefetch_wasted_counter++;
 
-	// remove block from blocks array
-	pBlockArray[block_id] = nullptr;
+	// remove block from the cache algorithm
+	static_cast<Policy*>(shard.policy)->remove(*block_p);
 
-	// remove block from file map
-	auto blocks_set = file_block_map[block_p->file_id];
-	blocks_set->erase(block_p);
+	// remove block from blocks array and return its id to the free ids stack
+	pBlockArray[block_id] = nullptr;
+	shard.free_ids.push_back(block_id);
 
-	// free allocated memory
-	delete block_p;
+	// remove block from the block index
+	shard.block_index.erase(block_p->file_id, block_p->block_num);
 
-	g_blocks_counter--;
+	shard.blocks_counter--;
 }
 
 /**
- * Returns the file size for a given file
- * @param path path to a file
- * @return if successful the file size, otherwise -1.
+ * Returns the shard that owns a block id
+ * @param block_id a block id
+ * @return the block shard
  */
-static off_t get_file_size(const char* path)
+static Shard& get_id_shard(int block_id)
 {
-	struct stat fi;
-	int ret = stat(path, &fi);
-
-	if (ret != 0)
-		return ret;
+	int i = 0;
+	while (block_id >= pShards[i].first_id + pShards[i].capacity)
+		i++;
+	return pShards[i];
+}
 
-	return fi.st_size;
+/**
+ * Writes a block log line to a log file
+ * @param log_fd log file descriptor
+ * @param block the block to log
+ * @return the number of bytes written, -1 if failed
+ */
+static ssize_t print_block(int log_fd, const Block& block)
+{
+	std::string log_line = fd_path_map.at(block.file_id) + " " + std::to_string(block.block_num) + "\n";
+	return write(log_fd, log_line.c_str(), log_line.length());
 }
 
 /**
@@ -670,3 +1941,100 @@ static int get_unique_cache_fd()
 	}
 	return cache_fd;
 }
+
+/**
+ * Removes all the cached blocks of the given file, and the keys the cache algorithm keeps of its removed blocks
+ * @param fd file descriptor
+ */
+static void remove_file_blocks(int fd)
+{
+	for (int i = 0; i < g_shards_num; ++i)
+	{
+		Shard& shard = pShards[i];
+		std::unique_lock<std::mutex> lock(shard.lock);
+		for (int id = shard.first_id; id < shard.first_id + shard.capacity; ++id)
+		{
+			if (pBlockArray[id] == nullptr || pBlockArray[id]->file_id != fd)
+				continue;
+			// wait for blocks that are being read, the block might have been removed meanwhile
+			// and its id reused by a block of another file, which may wait for the files lock
+			while (pBlockArray[id] != nullptr && pBlockArray[id]->file_id == fd && pBlockArray[id]->loading)
+				shard.block_loaded.wait(lock);
+			if (pBlockArray[id] != nullptr && pBlockArray[id]->file_id == fd)
+				g_engine.remove_block(shard, id);
+		}
+		shard.policy->forget(fd);
+		shard.miss_latency.erase(fd);
+	}
+}
+
+/**
+ * Releases the blocks pool, their buffers and the block array
+ */
+static void free_blocks()
+{
+	delete[] pBlockPool;
+	free(pBufferArena);
+	free(pBlockArray);
+	pBlockPool = nullptr;
+	pBufferArena = nullptr;
+	pBlockArray = nullptr;
+}
+
+/**
+ * Splits the cache blocks between the shards and initializes the shards data structures
+ * Caches with less than 2*MIN_SHARD_BLOCKS blocks have a single shard
+ * @param blocks_num max number of blocks
+ * @return 0 if successful, otherwise -1.
+ */
+static int init_shards(int blocks_num)
+{
+	g_shards_num = 1;
+	while (g_shards_num*2 <= MAX_SHARDS && blocks_num/(g_shards_num*2) >= MIN_SHARD_BLOCKS)
+		g_shards_num *= 2;
+
+	pShards = new (std::nothrow) Shard[g_shards_num];
+	if (pShards == nullptr)
+		return -1;
+
+	int first_id = 0;
+	for (int i = 0; i < g_shards_num; ++i)
+	{
+		Shard& shard = pShards[i];
+		shard.first_id = first_id;
+		shard.capacity = blocks_num/g_shards_num + (i < blocks_num%g_shards_num ? 1 : 0);
+		first_id += shard.capacity;
+
+		PolicyConfig config;
+		config.capacity = shard.capacity;
+		config.first_id = shard.first_id;
+		config.f_old = PART_OLD;
+		config.f_new = PART_NEW;
+		shard.policy = g_engine.create_policy(config);
+		if (g_engine.read_unlocked != nullptr)
+			shard.read_guards = new (std::nothrow) ReadGuard[shard.capacity];
+		if (shard.policy == nullptr || shard.block_index.init(shard.capacity) == -1 ||
+			(g_engine.read_unlocked != nullptr && shard.read_guards == nullptr))
+		{
+			delete[] pShards;
+			pShards = nullptr;
+			return -1;
+		}
+
+		try
+		{
+			// the free ids stack has the lowest id at the top
+			shard.free_ids.reserve(shard.capacity);
+			for (int id = shard.first_id + shard.capacity - 1; id >= shard.first_id; --id)
+				shard.free_ids.push_back(id);
+
+		} catch (std::bad_alloc& e)
+		{
+			delete[] pShards;
+			pShards = nullptr;
+			return -1;
+		}
+	}
+
+	return 0;
+}
@@ -8,15 +8,41 @@
 #define CACHEFS_H
 
 #include <stdlib.h>
+#include <sys/uio.h>
 
 // This enum represents a cache algorithm.
 // The possible values are all the cache algorithms that the library supports.
 enum cache_algo_t{
 	LRU,
 	LFU,
-	FBR
+	FBR,
+	ARC,
+	LIRS,
+	TINYLFU,
+	CLOCKPRO,
+	S3FIFO,
+	GDSF,
+	SAMPLED_LRU,
+	SAMPLED_LFU
 };
 
+// A read only view of the cached data of a single block, returned by CacheFS_pread_ref.
+// The block is pinned in the cache until the view is released by CacheFS_release.
+typedef struct cachefs_view{
+	const void* data;	// the view data, inside the cache
+	size_t size;		// the number of bytes in the view
+	int block_id;		// the cache block, used by CacheFS_release
+} cachefs_view_t;
+
+// A single read request of CacheFS_pread_batch.
+typedef struct cachefs_read{
+	int file_id;	// the file to read from
+	void* buf;		// the output buffer
+	size_t count;	// the number of bytes to read
+	off_t offset;	// the file offset
+	int result;		// set by CacheFS_pread_batch, like the CacheFS_pread returned value
+} cachefs_read_t;
+
 /**
  Initializes the CacheFS.
  Assumptions:
@@ -76,6 +102,48 @@ int CacheFS_init(int blocks_num, cache_algo_t cache_algo,
 int CacheFS_destroy();
 
 
+/**
+ Enables sequential readahead.
+ Every open file has a sequential access detector. Once a file is read sequentially,
+ the next blocks of the file are read into the cache together with the requested blocks.
+ The readahead window starts small, doubles while the stream keeps reading the prefetched
+ blocks, and shrinks when prefetched blocks are evicted before they are read.
+ Readahead is disabled by default, and CacheFS_init disables it.
+
+ When readahead is enabled, or after CacheFS_prefetch was used, CacheFS_print_stat writes three more lines:
+ Prefetched blocks: PREFETCHED_NUM
+ Prefetch hits: PREFETCH_HITS_NUM
+ Prefetch wasted: PREFETCH_WASTED_NUM
+ Where PREFETCHED_NUM is the number of blocks read by readahead, PREFETCH_HITS_NUM is the number
+ of prefetched blocks that were then required (these aren't counted as cache hits), and
+ PREFETCH_WASTED_NUM is the number of prefetched blocks that were removed before they were required.
+ Prefetched blocks aren't written by CacheFS_print_cache until they are required.
+
+ Parameters:
+	max_blocks - the max readahead window in blocks, 0 disables readahead
+
+ Returned value:
+    0 in case of success, negative value in case of failure.
+	The function will fail if max_blocks is negative or bigger than half of the cache blocks.
+ */
+int CacheFS_set_readahead(int max_blocks);
+
+
+/**
+ Starts reading a range of an open file into the cache, and returns without waiting for it.
+ The blocks are read in the background when the system supports io_uring, otherwise they are
+ read before the function returns. A read of a block that is still being read waits for it.
+ The prefetched blocks are counted like readahead blocks (see CacheFS_set_readahead).
+ The range is cut to the number of blocks the cache can hold (big caches count a single shard of
+ the cache, see README), the blocks after them aren't prefetched.
+
+ Returned value:
+    0 in case of success, negative value in case of failure.
+	The function will fail if file_id isn't an open file or offset is negative.
+ */
+int CacheFS_prefetch(int file_id, off_t offset, size_t count);
+
+
 /**
  File open operation.
  Receives a path for a file, opens it, and returns an id
@@ -88,6 +156,8 @@ int CacheFS_destroy();
 	3. The pathname is not unique per file, because:
 		a. relative paths are not unique: "myFolder/../tmp" and "tmp".
 		b. we might open a link ("short-cut") to the file
+	   Files are identified by their device and inode numbers, so all the names of
+	   a file share the same cached blocks.
 
  Parameters:
     pathname - the path to the file that will be opened
@@ -155,6 +225,74 @@ int CacheFS_close(int file_id);
 int CacheFS_pread(int file_id, void *buf, size_t count, off_t offset);
 
 
+/**
+   Read data from an open file into several buffers.
+
+   Works like CacheFS_pread, the range starts at offset and its size is the total size
+   of the buffers. The data is scattered over the buffers in order, like POSIX's preadv.
+   Each block of the range is accessed once, even if its data goes to several buffers.
+
+ Returned value:
+    In case of success:
+		Non negative value represents the number of bytes read.
+
+ 	In case of failure:
+		Negative number.
+		A failure will occur if:
+			1. a system call or a library function fails (e.g. pread).
+			2. invalid parameters (see CacheFS_pread), or iovcnt is negative or bigger than IOV_MAX.
+ */
+int CacheFS_preadv(int file_id, const struct iovec* iov, int iovcnt, off_t offset);
+
+
+/**
+   Read several ranges, of one or more open files, at once.
+
+   Works like calling CacheFS_pread for each request, but every block that is needed
+   by the requests is accessed once, in the order of the files and the block numbers,
+   and consecutive missing blocks are read from the file together.
+   Each request result is set like the CacheFS_pread returned value.
+
+ Returned value:
+	0 if all the requests were successful, negative value otherwise.
+ */
+int CacheFS_pread_batch(cachefs_read_t* reads, int reads_num);
+
+
+/**
+   Read data from an open file without copying it.
+
+   Works like CacheFS_pread, but instead of copying the data into a buffer it returns
+   read only views of the cached blocks, one view per block, in the order of the data.
+   The views point to the cache memory, the blocks are pinned until the views are released
+   by CacheFS_release, and the cache algorithms never evict a pinned block.
+   If the range needs more than max_views views, only the first max_views views are returned.
+   All the views of a file must be released before the file is closed.
+
+ Returned value:
+    In case of success:
+		The number of views. The total size of the views is the number of bytes read.
+
+ 	In case of failure:
+		Negative number, no block stays pinned.
+		A failure will occur if:
+			1. a system call or a library function fails (e.g. pread).
+			2. invalid parameters (see CacheFS_pread), or views is NULL.
+			3. a block has to be added to the cache, but all the blocks that could make room for it are pinned.
+ */
+int CacheFS_pread_ref(int file_id, cachefs_view_t* views, int max_views, size_t count, off_t offset);
+
+
+/**
+   Releases views that were returned by CacheFS_pread_ref.
+   The views data can't be used after they are released.
+
+ Returned value:
+	0 in case of success, negative value in case of failure.
+ */
+int CacheFS_release(cachefs_view_t* views, int views_num);
+
+
 /**
 This function writes the current state of the cache to a file.
 The function writes a line for every block that was used in the cache
@@ -167,6 +305,18 @@ Each line contains the following values separated by a single space.
 For LRU and LFU The order of the entries is from the last block that will be evicted from the cache
 to the first (next) block that will be evicted.
 For FBR use the LRU order (the order of the stack).
+For ARC the blocks that were accessed more than once (T2) are written before the blocks that were
+accessed once (T1), each list from the most recently used block to the least recently used block.
+For LIRS the LIR blocks are written first, from the most recently used one, and then the HIR blocks
+from the last to the first one that will be evicted.
+For TINYLFU the protected blocks are written first, then the window blocks and then the probation blocks,
+each list from the most recently used block to the least recently used block.
+For CLOCKPRO the blocks are written in the clock order, ending with the block the cold hand is on.
+For S3FIFO the main queue blocks are written before the small queue blocks, each queue from its newest block
+to its oldest block.
+For GDSF the blocks are written from the highest credit to the lowest credit.
+For SAMPLED_LRU and SAMPLED_LFU the blocks are written from the highest score (last access time or access count)
+to the lowest, the order the blocks would be evicted in if every eviction sampled all of them.
 
 Notes:
 	1. If log_path is a path to existed file - the function will append the cache
@@ -0,0 +1,110 @@
+#ifndef CACHEFS_CACHEPOLICY_H
+#define CACHEFS_CACHEPOLICY_H
+
+#include <vector>
+#include "Block.h"
+
+/**
+ * The parameters a cache algorithm is created with
+ */
+struct PolicyConfig {
+	/**
+	 * The max number of blocks the algorithm manages
+	 */
+	int capacity;
+
+	/**
+	 * The id of the first managed block, the managed block ids are [first_id, first_id + capacity)
+	 */
+	int first_id;
+
+	/**
+	 * The old and new partitions sizes in %, relevant in FBR algorithm only
+	 */
+	double f_old;
+	double f_new;
+};
+
+/**
+ * Base class of the cache algorithms, every shard has its own algorithm object that orders the shard blocks.
+ * The cache engine is a template over the algorithm class, so the calls made on every block access aren't virtual
+ * and each algorithm defines them in its header, where the engine can inline them:
+ *   void insert(Block& block) - a block was added to the cache, a prefetched block is marked before it's added
+ *   void access(Block& block) - a cached block was accessed
+ *   int victim()              - returns the next block to evict that isn't pinned, -1 if all the blocks are pinned
+ *   void remove(Block& block) - a block is removed from the cache
+ *   void cost_changed(Block& block, double cost) - the miss cost of a block is set before it's added,
+ *                             and changes when its read is timed (the base class ignores it)
+ * An algorithm whose access only makes atomic stores to its own per block state sets UNLOCKED_ACCESS,
+ * then the engine finds and reads cached blocks and calls access without the shard lock.
+ * An algorithm that orders the blocks by their miss cost sets USES_COST, the engine doesn't track the cost otherwise.
+ */
+class CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool, block ids are indices in it
+	 */
+	explicit CachePolicy(Block* pool) : _pool(pool) {}
+
+	/**
+	 * Destructor
+	 */
+	virtual ~CachePolicy() {}
+
+	/**
+	 * True if access can be called without the shard lock
+	 */
+	static const bool UNLOCKED_ACCESS = false;
+
+	/**
+	 * True if the blocks miss cost is used, then cost_changed is called before a block is added
+	 * and once its read is timed
+	 */
+	static const bool USES_COST = false;
+
+	/**
+	 * Allocates the algorithm data structures
+	 * @param config the algorithm parameters
+	 * @return 0 if successful, otherwise -1.
+	 */
+	virtual int init(const PolicyConfig& config) = 0;
+
+	/**
+	 * Appends the ids of the managed blocks, from the last block that will be evicted to the next one
+	 * @param ids the vector to append the ids to
+	 */
+	virtual void order(std::vector<int>& ids) const = 0;
+
+	/**
+	 * A file was closed and all its blocks were removed, the algorithms that keep the keys of removed blocks
+	 * drop the keys of the file, since the file descriptor may be reused by another file
+	 * @param file_id the closed file
+	 */
+	virtual void forget(int file_id)
+	{
+		(void) file_id;
+	}
+
+	/**
+	 * The miss cost of a block changed, the algorithms that don't use the cost don't define it
+	 * @param block a cached block or a block that is about to be added
+	 * @param cost the new miss cost
+	 */
+	void cost_changed(Block& block, double cost)
+	{
+		(void) block;
+		(void) cost;
+	}
+
+	CachePolicy(const CachePolicy&) = delete;
+	CachePolicy& operator=(const CachePolicy&) = delete;
+
+protected:
+	/**
+	 * The cache block pool
+	 */
+	Block* _pool;
+};
+
+#endif //CACHEFS_CACHEPOLICY_H
@@ -0,0 +1,355 @@
+#include "ClockProPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+ClockProPolicy::ClockProPolicy(Block* pool) : CachePolicy(pool), _first_id(0), _hand_cold(-1), _hand_hot(-1),
+											  _hand_test(-1), _capacity(0), _cold_target(1), _hot_count(0),
+											  _cold_count(0), _test_count(0)
+{
+}
+
+/**
+ * Allocates the entries pool, the reference bits and the block entries, the cold target starts at one block
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int ClockProPolicy::init(const PolicyConfig& config)
+{
+	_first_id = config.first_id;
+	_capacity = config.capacity;
+	_cold_target = 1;
+	_hot_count = 0;
+	_cold_count = 0;
+	_test_count = 0;
+	_hand_cold = -1;
+	_hand_hot = -1;
+	_hand_test = -1;
+
+	size_t entries_num = 2*(size_t)_capacity + 1;
+	try
+	{
+		_entries.resize(entries_num);
+		_free_entries.clear();
+		_free_entries.reserve(entries_num);
+		_referenced.assign((size_t)_capacity, 0);
+		_block_entries.assign((size_t)_capacity, -1);
+		_test_index.clear();
+		_test_index.reserve((size_t)_capacity + 1);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	for (int entry_id = (int)entries_num - 1; entry_id >= 0; --entry_id)
+		_free_entries.push_back(entry_id);
+	return 0;
+}
+
+/**
+ * Appends the cached blocks in the clock order, from the block the cold hand will reach last to the cold hand
+ * @param ids the vector to append the ids to
+ */
+void ClockProPolicy::order(std::vector<int>& ids) const
+{
+	if (_hand_cold == -1)
+		return;
+	int entry_id = _hand_cold;
+	do
+	{
+		entry_id = _entries[entry_id].prev;
+		if (_entries[entry_id].block_id != -1)
+			ids.push_back(_entries[entry_id].block_id);
+	} while (entry_id != _hand_cold);
+}
+
+/**
+ * Releases the test entries of a closed file
+ * @param file_id the closed file
+ */
+void ClockProPolicy::forget(int file_id)
+{
+	int entries_num = _hot_count + _cold_count + _test_count;
+	int entry_id = _hand_hot;
+	for (int i = 0; i < entries_num; ++i)
+	{
+		const Entry& entry = _entries[entry_id];
+		int next = entry.next;
+		if (entry.block_id == -1 && (uint32_t)(entry.key >> 32) == (uint32_t)file_id)
+		{
+			_test_count--;
+			entry_release(entry_id);
+		}
+		entry_id = next;
+	}
+}
+
+/**
+ * Adds a new block at the head of the clock with a clear reference bit
+ * A block whose key has a test entry was evicted too early, so it's added as hot and the cold target grows,
+ * any other block is added as cold in its test period
+ * @param block the new block
+ */
+void ClockProPolicy::insert(Block& block)
+{
+	uint64_t key = block_key(block);
+	set_referenced(block.id, 0);
+
+	auto test_iter = _test_index.find(key);
+	if (test_iter != _test_index.end())
+	{
+		_cold_target = std::min(_cold_target + 1, _capacity);
+		_test_count--;
+		entry_release(test_iter->second);
+		block_entry(block.id) = entry_create(key, block.id, true);
+		_hot_count++;
+		shrink_hot();
+	}
+	else
+	{
+		int entry_id = entry_create(key, block.id, false);
+		_entries[entry_id].test = true;
+		block_entry(block.id) = entry_id;
+		_cold_count++;
+	}
+}
+
+/**
+ * Moves the cold hand until it reaches a cold block that isn't referenced or pinned. On the way a referenced cold
+ * block moves to the head of the clock, it becomes hot if it's in its test period, otherwise it starts a test period,
+ * and the hot hand runs while there are too many hot blocks
+ * When the hands can't find such a block, any cached block that isn't pinned is returned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int ClockProPolicy::victim()
+{
+	int steps = 4*(_hot_count + _cold_count + _test_count);
+	for (int step = 0; _hand_cold != -1 && step < steps; ++step)
+	{
+		int entry_id = _hand_cold;
+		Entry& entry = _entries[entry_id];
+		_hand_cold = entry.next;
+		if (entry.block_id == -1 || entry.hot)
+			continue;
+
+		if (!referenced(entry.block_id))
+		{
+			if (_pool[entry.block_id].pin_count > 0)
+				continue;
+			_hand_cold = entry_id;
+			return entry.block_id;
+		}
+
+		set_referenced(entry.block_id, 0);
+		entry_move_to_head(entry_id);
+		if (entry.test)
+		{
+			entry.hot = true;
+			entry.test = false;
+			_cold_count--;
+			_hot_count++;
+			shrink_hot();
+		}
+		else
+			entry.test = true;
+	}
+
+	if (_hand_cold == -1)
+		return -1;
+	int entry_id = _hand_cold;
+	do
+	{
+		const Entry& entry = _entries[entry_id];
+		if (entry.block_id != -1 && _pool[entry.block_id].pin_count == 0)
+			return entry.block_id;
+		entry_id = entry.next;
+	} while (entry_id != _hand_cold);
+	return -1;
+}
+
+/**
+ * Removes the block, a cold block in its test period stays on the clock as a test entry and any other block leaves it
+ * The test hand runs while there are too many test entries
+ * @param block a cached block
+ */
+void ClockProPolicy::remove(Block& block)
+{
+	int entry_id = block_entry(block.id);
+	Entry& entry = _entries[entry_id];
+	block_entry(block.id) = -1;
+	set_referenced(block.id, 0);
+
+	if (entry.hot)
+	{
+		_hot_count--;
+		entry_release(entry_id);
+		return;
+	}
+	_cold_count--;
+	if (!entry.test)
+	{
+		entry_release(entry_id);
+		return;
+	}
+
+	entry.block_id = -1;
+	_test_index[entry.key] = entry_id;
+	_test_count++;
+	while (_test_count > _capacity)
+		run_hand_test();
+}
+
+/**
+ * Adds a new entry at the head of the clock, right before the hot hand, so all the hands reach it last
+ * @param key the block key
+ * @param block_id the cached block
+ * @param hot true if the block is hot
+ * @return the entry
+ */
+int ClockProPolicy::entry_create(uint64_t key, int block_id, bool hot)
+{
+	int entry_id = _free_entries.back();
+	_free_entries.pop_back();
+
+	Entry& entry = _entries[entry_id];
+	entry.key = key;
+	entry.block_id = block_id;
+	entry.hot = hot;
+	entry.test = false;
+	link_head(entry_id);
+	return entry_id;
+}
+
+/**
+ * Removes an entry from the clock and releases it, the hands on it move to the next entry
+ * @param entry_id the entry
+ */
+void ClockProPolicy::entry_release(int entry_id)
+{
+	Entry& entry = _entries[entry_id];
+	if (entry.block_id == -1)
+		_test_index.erase(entry.key);
+	unlink(entry_id);
+	_free_entries.push_back(entry_id);
+}
+
+/**
+ * Moves an entry to the head of the clock
+ * @param entry_id the entry
+ */
+void ClockProPolicy::entry_move_to_head(int entry_id)
+{
+	unlink(entry_id);
+	link_head(entry_id);
+}
+
+/**
+ * Links an entry at the head of the clock, right before the hot hand
+ * @param entry_id an entry that isn't on the clock
+ */
+void ClockProPolicy::link_head(int entry_id)
+{
+	Entry& entry = _entries[entry_id];
+	if (_hand_hot == -1)
+	{
+		entry.prev = entry_id;
+		entry.next = entry_id;
+		_hand_cold = entry_id;
+		_hand_hot = entry_id;
+		_hand_test = entry_id;
+		return;
+	}
+	entry.next = _hand_hot;
+	entry.prev = _entries[_hand_hot].prev;
+	_entries[entry.prev].next = entry_id;
+	_entries[_hand_hot].prev = entry_id;
+}
+
+/**
+ * Unlinks an entry from the clock, the hands on it move to the next entry
+ * @param entry_id an entry on the clock
+ */
+void ClockProPolicy::unlink(int entry_id)
+{
+	Entry& entry = _entries[entry_id];
+	int next = entry.next == entry_id ? -1 : entry.next;
+	if (_hand_cold == entry_id)
+		_hand_cold = next;
+	if (_hand_hot == entry_id)
+		_hand_hot = next;
+	if (_hand_test == entry_id)
+		_hand_test = next;
+	_entries[entry.prev].next = entry.next;
+	_entries[entry.next].prev = entry.prev;
+}
+
+/**
+ * Runs the hot hand while there are too many hot blocks
+ * Hits set the reference bits without the shard lock, so threads that keep hitting the hot blocks could keep the
+ * hand going forever. After a full sweep of the clock the hand turns the hot blocks it reaches cold anyway
+ */
+void ClockProPolicy::shrink_hot()
+{
+	int steps = _hot_count + _cold_count + _test_count;
+	for (int step = 0; _hot_count > _capacity - _cold_target; ++step)
+		run_hand_hot(step >= steps);
+}
+
+/**
+ * Moves the hot hand one entry, a referenced hot block is cleared and any other hot block becomes cold,
+ * the test period of a cold block ends when the hot hand passes it, since it's older than all the hot blocks now
+ * @param demote true if a referenced hot block becomes cold too
+ */
+void ClockProPolicy::run_hand_hot(bool demote)
+{
+	int entry_id = _hand_hot;
+	Entry& entry = _entries[entry_id];
+	_hand_hot = entry.next;
+	if (!entry.hot)
+	{
+		if (entry.test)
+			end_test(entry_id);
+		return;
+	}
+
+	if (referenced(entry.block_id))
+	{
+		set_referenced(entry.block_id, 0);
+		if (!demote)
+			return;
+	}
+	entry.hot = false;
+	_hot_count--;
+	_cold_count++;
+}
+
+/**
+ * Moves the test hand one entry, the test period of a cold block ends
+ */
+void ClockProPolicy::run_hand_test()
+{
+	int entry_id = _hand_test;
+	Entry& entry = _entries[entry_id];
+	_hand_test = entry.next;
+	if (!entry.hot && entry.test)
+		end_test(entry_id);
+}
+
+/**
+ * Ends the test period of a cold block or a test entry, a test entry is dropped,
+ * and the cold target shrinks since the block wasn't accessed again in its test period
+ * @param entry_id the entry
+ */
+void ClockProPolicy::end_test(int entry_id)
+{
+	Entry& entry = _entries[entry_id];
+	entry.test = false;
+	if (entry.block_id == -1)
+	{
+		_test_count--;
+		entry_release(entry_id);
+	}
+	_cold_target = std::max(_cold_target - 1, 1);
+}
@@ -0,0 +1,221 @@
+#ifndef CACHEFS_CLOCKPROPOLICY_H
+#define CACHEFS_CLOCKPROPOLICY_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "CachePolicy.h"
+
+/**
+ * CLOCK-Pro, an approximation of LIRS on a clock. The cached blocks are hot or cold, and the keys of cold blocks
+ * that were evicted recently stay on the clock as test entries. A cold block that is referenced again before the
+ * cold hand reaches it becomes hot, and a miss on a test entry adds the block as hot and grows the cold target.
+ * A hit only sets the block's reference bit, the three hands sweep the clock on the miss path:
+ * the cold hand looks for the block to evict, the hot hand turns unreferenced hot blocks cold when there are too many,
+ * and the test hand drops old test entries.
+ */
+class ClockProPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit ClockProPolicy(Block* pool);
+
+	/**
+	 * A hit only sets the reference bit, so hits don't take the shard lock
+	 */
+	static const bool UNLOCKED_ACCESS = true;
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+	void forget(int file_id) override;
+
+	/**
+	 * Adds a new block at the head of the clock, as hot if its key has a test entry, otherwise as cold
+	 */
+	void insert(Block& block);
+
+	/**
+	 * Sets the block reference bit, the clock isn't changed
+	 */
+	void access(Block& block)
+	{
+		set_referenced(block.id, 1);
+	}
+
+	/**
+	 * Moves the cold hand to the next cold block that isn't referenced or pinned, and returns it,
+	 * -1 if all the blocks are pinned
+	 */
+	int victim();
+
+	/**
+	 * Removes the block, a cold block becomes a test entry
+	 */
+	void remove(Block& block);
+
+private:
+	/**
+	 * An entry of the clock
+	 */
+	struct Entry {
+		/**
+		 * The block key
+		 */
+		uint64_t key;
+
+		/**
+		 * The cached block, -1 for a test entry
+		 */
+		int block_id;
+
+		/**
+		 * True if the block is hot
+		 */
+		bool hot;
+
+		/**
+		 * True if a cold block or a test entry is in its test period, a test entry is always in its test period
+		 */
+		bool test;
+
+		/**
+		 * The neighbours on the clock, the hands move to next
+		 */
+		int prev, next;
+	};
+
+	/**
+	 * The entries pool, there are at most capacity cached blocks and capacity + 1 test entries,
+	 * and the unused entries
+	 */
+	std::vector<Entry> _entries;
+	std::vector<int> _free_entries;
+
+	/**
+	 * The reference bits and the entry of every block, parallel to the shard's part of the block array
+	 */
+	std::vector<uint8_t> _referenced;
+	std::vector<int> _block_entries;
+
+	/**
+	 * The first block id of the shard
+	 */
+	int _first_id;
+
+	/**
+	 * Maps the key of a test entry to the entry
+	 */
+	std::unordered_map<uint64_t, int> _test_index;
+
+	/**
+	 * The hands, -1 when the clock is empty. New entries are added right before the hot hand
+	 */
+	int _hand_cold;
+	int _hand_hot;
+	int _hand_test;
+
+	/**
+	 * The max number of cached blocks, the target number of cold blocks
+	 * and the current numbers of hot blocks, cold blocks and test entries
+	 */
+	int _capacity;
+	int _cold_target;
+	int _hot_count;
+	int _cold_count;
+	int _test_count;
+
+	/**
+	 * Returns the reference bit of a block, hits set the bits without the shard lock so they are atomic
+	 * @param block_id the block id
+	 */
+	uint8_t referenced(int block_id) const
+	{
+		return __atomic_load_n(&_referenced[block_id - _first_id], __ATOMIC_RELAXED);
+	}
+
+	/**
+	 * Sets or clears the reference bit of a block
+	 * @param block_id the block id
+	 * @param value the new bit
+	 */
+	void set_referenced(int block_id, uint8_t value)
+	{
+		__atomic_store_n(&_referenced[block_id - _first_id], value, __ATOMIC_RELAXED);
+	}
+
+	/**
+	 * Returns the entry of a block, -1 if the block isn't cached
+	 * @param block_id the block id
+	 */
+	int& block_entry(int block_id)
+	{
+		return _block_entries[block_id - _first_id];
+	}
+
+	/**
+	 * Returns the key of a block
+	 */
+	static uint64_t block_key(const Block& block)
+	{
+		return ((uint64_t)(uint32_t)block.file_id << 32) | (uint32_t)block.block_num;
+	}
+
+	/**
+	 * Adds a new entry at the head of the clock
+	 * @param key the block key
+	 * @param block_id the cached block
+	 * @param hot true if the block is hot
+	 * @return the entry
+	 */
+	int entry_create(uint64_t key, int block_id, bool hot);
+
+	/**
+	 * Removes an entry from the clock and releases it, the hands on it move to the next entry
+	 * @param entry_id the entry
+	 */
+	void entry_release(int entry_id);
+
+	/**
+	 * Moves an entry to the head of the clock
+	 * @param entry_id the entry
+	 */
+	void entry_move_to_head(int entry_id);
+
+	/**
+	 * Links an entry at the head of the clock, right before the hot hand
+	 * @param entry_id an entry that isn't on the clock
+	 */
+	void link_head(int entry_id);
+
+	/**
+	 * Unlinks an entry from the clock, the hands on it move to the next entry
+	 * @param entry_id an entry on the clock
+	 */
+	void unlink(int entry_id);
+
+	/**
+	 * Runs the hot hand until there is room for the cold target
+	 */
+	void shrink_hot();
+
+	/**
+	 * Moves the hot hand one entry, a hot block is cleared or turned cold and a test period ends
+	 * @param demote true if a hot block is turned cold even if it's referenced
+	 */
+	void run_hand_hot(bool demote);
+
+	/**
+	 * Moves the test hand one entry, a test period ends
+	 */
+	void run_hand_test();
+
+	/**
+	 * Ends the test period of a cold block or a test entry, a test entry is dropped
+	 * @param entry_id the entry
+	 */
+	void end_test(int entry_id);
+};
+
+#endif //CACHEFS_CLOCKPROPOLICY_H
@@ -0,0 +1,154 @@
+#include "FBRPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+FBRPolicy::FBRPolicy(Block* pool) : CachePolicy(pool), _first_id(0), _stamp(0), _f_old(0), _f_new(0), _new_count(0),
+									 _new_boundary(-1), _old_count(0), _old_boundary(-1), _old_blocks(OldCompare{this})
+{
+	_queue.init(pool, 0);
+}
+
+/**
+ * Initializes an empty queue and allocates the block slots
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int FBRPolicy::init(const PolicyConfig& config)
+{
+	_queue.init(_pool, 0);
+	_first_id = config.first_id;
+	try
+	{
+		_slots.assign((size_t)config.capacity, Slot{0, false, false});
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	_stamp = 0;
+	_f_old = config.f_old;
+	_f_new = config.f_new;
+	_new_count = 0;
+	_new_boundary = -1;
+	_old_count = 0;
+	_old_boundary = -1;
+	_old_blocks.clear();
+	return 0;
+}
+
+/**
+ * Appends the blocks from the end of the queue to its head (the order of the LRU stack)
+ * @param ids the vector to append the ids to
+ */
+void FBRPolicy::order(std::vector<int>& ids) const
+{
+	for (int id = _queue.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+}
+
+/**
+ * Returns the block with the lowest reference count in the old section that isn't pinned
+ * When all the old section blocks are pinned, returns the least recently used block that isn't pinned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int FBRPolicy::victim() const
+{
+	// the old section blocks are ordered by reference count and then by queue position
+	for (int id : _old_blocks)
+		if (_pool[id].pin_count == 0)
+			return id;
+
+	int id = _queue.head();
+	while (id != -1 && _pool[id].pin_count > 0)
+		id = _pool[id].next;
+	return id;
+}
+
+/**
+ * Moves the new and old section boundaries until the sections have the right size for the current queue size
+ * A queue change moves each boundary by a constant number of blocks
+ */
+void FBRPolicy::update_sections()
+{
+	int new_size = new_section_size(_queue.size());
+	int old_size = old_section_size(_queue.size());
+	Block* block_p;
+
+	// the new section is at the end of the queue
+	while (_new_count > new_size)
+	{
+		block_p = &_pool[_new_boundary];
+		slot(block_p->id).in_new = false;
+		_new_boundary = block_p->next;
+		_new_count--;
+	}
+	while (_new_count < new_size)
+	{
+		_new_boundary = (_new_boundary == -1) ? _queue.tail() : _pool[_new_boundary].prev;
+		slot(_new_boundary).in_new = true;
+		_new_count++;
+	}
+
+	// the old section is at the beginning of the queue
+	while (_old_count > old_size)
+	{
+		block_p = &_pool[_old_boundary];
+		slot(block_p->id).in_old = false;
+		_old_blocks.erase(block_p->id);
+		_old_boundary = block_p->prev;
+		_old_count--;
+	}
+	while (_old_count < old_size)
+	{
+		_old_boundary = (_old_boundary == -1) ? _queue.head() : _pool[_old_boundary].next;
+		block_p = &_pool[_old_boundary];
+		slot(block_p->id).in_old = true;
+		_old_blocks.insert(block_p->id);
+		_old_count++;
+	}
+}
+
+/**
+ * Returns the number of blocks in the new section
+ * A block is new if its distance from the end of the queue divided by the queue size is at most f_new
+ * @param queue_size the number of blocks in the queue
+ * @return the new section size
+ */
+int FBRPolicy::new_section_size(int queue_size) const
+{
+	if (queue_size == 0)
+		return 0;
+
+	// start from the rounded estimate and fix floating point rounding with the exact condition
+	int distance = std::min(std::max((int)(_f_new*queue_size), 0), queue_size - 1);
+	while (distance + 1 < queue_size && ((double)(distance + 1))/queue_size <= _f_new)
+		distance++;
+	while (distance > 0 && !(((double)distance)/queue_size <= _f_new))
+		distance--;
+
+	return distance + 1;
+}
+
+/**
+ * Returns the number of blocks in the old section
+ * The first block of the queue is always old, the block at index i is old if (i+1)/queue_size is at most f_old
+ * @param queue_size the number of blocks in the queue
+ * @return the old section size
+ */
+int FBRPolicy::old_section_size(int queue_size) const
+{
+	if (queue_size == 0)
+		return 0;
+
+	// start from the rounded estimate and fix floating point rounding with the exact condition
+	int size = std::min(std::max((int)(_f_old*queue_size), 0), queue_size);
+	while (size < queue_size && ((double)(size + 1))/queue_size <= _f_old)
+		size++;
+	while (size > 0 && !(((double)size)/queue_size <= _f_old))
+		size--;
+
+	return std::max(size, 1);
+}
@@ -0,0 +1,226 @@
+#ifndef CACHEFS_FBRPOLICY_H
+#define CACHEFS_FBRPOLICY_H
+
+#include <stddef.h>
+#include <set>
+#include <vector>
+#include "BlockList.h"
+#include "CachePolicy.h"
+
+/**
+ * Frequency based replacement, the blocks are kept in a queue ordered by their last access like LRU,
+ * the newest blocks are the new section and their reference count isn't increased when they are accessed,
+ * the oldest blocks are the old section and the block with the lowest reference count in it is evicted.
+ * The section boundaries are markers in the queue that are moved whenever the queue changes,
+ * and the sections of every block are kept in an array parallel to the shard's part of the block array.
+ */
+class FBRPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit FBRPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+
+	/**
+	 * A new block is accessed for the first time
+	 */
+	void insert(Block& block)
+	{
+		access(block);
+	}
+
+	/**
+	 * Moves the block to the end of the queue, the reference count is increased only outside of the new section
+	 */
+	void access(Block& block)
+	{
+		bool is_new = slot(block.id).in_new;
+
+		// remove block from queue before its reference count changes, it's part of the old section order
+		if (_queue.contains(block))
+			queue_remove(block);
+
+		if (!is_new)
+			block.reference_num++;
+
+		// add it to the back of the queue and move the section boundaries
+		queue_push_back(block);
+		update_sections();
+	}
+
+	/**
+	 * Returns the block with the lowest reference count in the old section that isn't pinned,
+	 * when all the old section blocks are pinned the least recently used block that isn't pinned,
+	 * -1 if all the blocks are pinned
+	 */
+	int victim() const;
+
+	/**
+	 * Removes the block from the queue and moves the section boundaries
+	 */
+	void remove(Block& block)
+	{
+		queue_remove(block);
+		update_sections();
+	}
+
+private:
+	/**
+	 * The FBR state of a block
+	 */
+	struct Slot {
+		/**
+		 * The order in which the block was last added to the end of the queue
+		 */
+		size_t stamp;
+
+		/**
+		 * True if the block is in the new section, or in the old section
+		 */
+		bool in_new;
+		bool in_old;
+	};
+
+	/**
+	 * Orders the blocks of the old section by reference count,
+	 * blocks with the same reference count are ordered by their position in the queue
+	 */
+	struct OldCompare {
+		const FBRPolicy* policy;
+
+		bool operator()(int lhs_id, int rhs_id) const
+		{
+			const Block& lhs = policy->_pool[lhs_id];
+			const Block& rhs = policy->_pool[rhs_id];
+			if (lhs.reference_num != rhs.reference_num)
+				return lhs.reference_num < rhs.reference_num;
+			return policy->slot(lhs_id).stamp < policy->slot(rhs_id).stamp;
+		}
+	};
+
+	/**
+	 * The block slots, parallel to the shard's part of the block array
+	 */
+	std::vector<Slot> _slots;
+
+	/**
+	 * The first block id of the shard
+	 */
+	int _first_id;
+
+	/**
+	 * The block queue, the head is the oldest block
+	 */
+	BlockList _queue;
+
+	/**
+	 * Counter used to stamp the blocks in the order they are added to the end of the queue
+	 */
+	size_t _stamp;
+
+	/**
+	 * The partitions sizes in %
+	 */
+	double _f_old;
+	double _f_new;
+
+	/**
+	 * The number of blocks at the end of the queue that are in the new section,
+	 * and the first (oldest) of them, -1 if the section is empty
+	 */
+	int _new_count;
+	int _new_boundary;
+
+	/**
+	 * The number of blocks at the beginning of the queue that are in the old section,
+	 * and the last (newest) of them, -1 if the section is empty
+	 */
+	int _old_count;
+	int _old_boundary;
+
+	/**
+	 * The blocks of the old section ordered by reference count, the first one is the next to be evicted
+	 */
+	std::set<int, OldCompare> _old_blocks;
+
+	/**
+	 * Adds a block to the end of the queue, the block becomes the newest block of the new section
+	 * @param block a block that isn't in the queue
+	 */
+	void queue_push_back(Block& block)
+	{
+		Slot& block_slot = slot(block.id);
+		block_slot.stamp = _stamp++;
+		_queue.push_back(block);
+
+		block_slot.in_new = true;
+		_new_count++;
+		if (_new_boundary == -1)
+			_new_boundary = block.id;
+	}
+
+	/**
+	 * Removes a block from the queue and from its sections
+	 * @param block a block in the queue
+	 */
+	void queue_remove(Block& block)
+	{
+		Slot& block_slot = slot(block.id);
+		if (block_slot.in_new)
+		{
+			if (_new_boundary == block.id)
+				_new_boundary = block.next;
+			block_slot.in_new = false;
+			_new_count--;
+		}
+		if (block_slot.in_old)
+		{
+			_old_blocks.erase(block.id);
+			if (_old_boundary == block.id)
+				_old_boundary = block.prev;
+			block_slot.in_old = false;
+			_old_count--;
+		}
+
+		_queue.remove(block);
+	}
+
+	/**
+	 * Returns the slot of a block
+	 * @param block_id the block id
+	 */
+	Slot& slot(int block_id)
+	{
+		return _slots[block_id - _first_id];
+	}
+
+	const Slot& slot(int block_id) const
+	{
+		return _slots[block_id - _first_id];
+	}
+
+	/**
+	 * Moves the new and old section boundaries until the sections have the right size for the current queue size
+	 */
+	void update_sections();
+
+	/**
+	 * Returns the number of blocks in the new section
+	 * @param queue_size the number of blocks in the queue
+	 * @return the new section size
+	 */
+	int new_section_size(int queue_size) const;
+
+	/**
+	 * Returns the number of blocks in the old section
+	 * @param queue_size the number of blocks in the queue
+	 * @return the old section size
+	 */
+	int old_section_size(int queue_size) const;
+};
+
+#endif //CACHEFS_FBRPOLICY_H
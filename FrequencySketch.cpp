@@ -0,0 +1,110 @@
+#include "FrequencySketch.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Allocates the sketch, a row has a counter for every expected key and the doorkeeper has 8 bits for every one
+ * @param expected_keys the number of keys the estimates should be accurate for
+ * @return 0 if successful, otherwise -1.
+ */
+int FrequencySketch::init(int expected_keys)
+{
+	_width = 16;
+	while (_width < (uint64_t)expected_keys)
+		_width <<= 1;
+	_doorkeeper_bits = _width << 3;
+	_additions = 0;
+	_sample_size = 10*(int64_t)std::max(expected_keys, 1);
+
+	try
+	{
+		_table.assign(ROWS*_width/16, 0);
+		_doorkeeper.assign(_doorkeeper_bits/64, 0);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Counts an access to a key, the first access only sets the key's doorkeeper bits,
+ * the next ones increment its counters in all the rows unless they are saturated
+ * @param key the key
+ */
+void FrequencySketch::increment(uint64_t key)
+{
+	uint64_t key_hash = hash(key);
+	if (!doorkeeper_contains(key_hash))
+	{
+		uint64_t bit = key_hash & (_doorkeeper_bits - 1);
+		_doorkeeper[bit >> 6] |= (uint64_t)1 << (bit & 63);
+		bit = (key_hash >> 32) & (_doorkeeper_bits - 1);
+		_doorkeeper[bit >> 6] |= (uint64_t)1 << (bit & 63);
+	}
+	else
+	{
+		for (int row = 0; row < ROWS; ++row)
+		{
+			uint64_t index = counter_index(key_hash, row);
+			if (counter(index) < 15)
+				_table[index >> 4] += (uint64_t)1 << ((index & 15) << 2);
+		}
+	}
+
+	if (++_additions >= _sample_size)
+		reset();
+}
+
+/**
+ * Returns the estimated number of recent accesses to a key,
+ * its smallest counter plus one if the doorkeeper has seen it since it was cleared
+ * @param key the key
+ * @return the estimate, at most 16
+ */
+int FrequencySketch::frequency(uint64_t key) const
+{
+	uint64_t key_hash = hash(key);
+	int estimate = 15;
+	for (int row = 0; row < ROWS; ++row)
+		estimate = std::min(estimate, counter(counter_index(key_hash, row)));
+	return doorkeeper_contains(key_hash) ? estimate + 1 : estimate;
+}
+
+/**
+ * Returns true if the doorkeeper has seen the key since it was cleared
+ * @param hash the key hash
+ */
+bool FrequencySketch::doorkeeper_contains(uint64_t hash) const
+{
+	uint64_t bit1 = hash & (_doorkeeper_bits - 1);
+	uint64_t bit2 = (hash >> 32) & (_doorkeeper_bits - 1);
+	return ((_doorkeeper[bit1 >> 6] >> (bit1 & 63)) & 1) && ((_doorkeeper[bit2 >> 6] >> (bit2 & 63)) & 1);
+}
+
+/**
+ * Halves all the counters and clears the doorkeeper
+ * Shifting a word right moves the low bit of every counter into the counter below it, the mask drops these bits
+ */
+void FrequencySketch::reset()
+{
+	for (uint64_t& word : _table)
+		word = (word >> 1) & 0x7777777777777777ULL;
+	std::fill(_doorkeeper.begin(), _doorkeeper.end(), 0);
+	_additions /= 2;
+}
+
+/**
+ * Spreads the bits of a key, the file id and block number are in separate halves of the key
+ * @param key the key
+ * @return the key hash
+ */
+uint64_t FrequencySketch::hash(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
@@ -0,0 +1,102 @@
+#ifndef CACHEFS_FREQUENCYSKETCH_H
+#define CACHEFS_FREQUENCYSKETCH_H
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Estimates how often keys were accessed recently, in a fixed amount of memory.
+ * A count-min sketch of 4 rows of 4-bit counters, packed 16 counters in a word, holds the counts,
+ * a key's estimate is its smallest counter. In front of it a doorkeeper bloom filter absorbs the first access
+ * of every key, so keys that are accessed once don't take counters from the others.
+ * After 10 accesses per expected key all the counters are halved and the doorkeeper is cleared,
+ * so the estimates follow changes in the workload.
+ */
+class FrequencySketch {
+public:
+	/**
+	 * Allocates the sketch
+	 * @param expected_keys the number of keys the estimates should be accurate for
+	 * @return 0 if successful, otherwise -1.
+	 */
+	int init(int expected_keys);
+
+	/**
+	 * Counts an access to a key
+	 * @param key the key
+	 */
+	void increment(uint64_t key);
+
+	/**
+	 * Returns the estimated number of recent accesses to a key, at most 16
+	 * @param key the key
+	 */
+	int frequency(uint64_t key) const;
+
+private:
+	/**
+	 * The sketch rows
+	 */
+	static const int ROWS = 4;
+
+	/**
+	 * The counters, ROWS rows of _width counters each
+	 */
+	std::vector<uint64_t> _table;
+
+	/**
+	 * The number of counters in a row, a power of 2
+	 */
+	uint64_t _width;
+
+	/**
+	 * The doorkeeper bits, the number of bits is a power of 2
+	 */
+	std::vector<uint64_t> _doorkeeper;
+	uint64_t _doorkeeper_bits;
+
+	/**
+	 * The accesses counted since the last halving, and the number of accesses that triggers halving
+	 */
+	int64_t _additions;
+	int64_t _sample_size;
+
+	/**
+	 * Returns the index of a key's counter in a row
+	 * @param hash the key hash
+	 * @param row the row
+	 */
+	uint64_t counter_index(uint64_t hash, int row) const
+	{
+		return (uint64_t)row*_width + ((hash + (uint64_t)row*((hash >> 32) | 1)) & (_width - 1));
+	}
+
+	/**
+	 * Returns the value of a counter
+	 * @param index the counter index
+	 */
+	int counter(uint64_t index) const
+	{
+		return (int)((_table[index >> 4] >> ((index & 15) << 2)) & 0xf);
+	}
+
+	/**
+	 * Returns true if the doorkeeper has seen the key since it was cleared
+	 * @param hash the key hash
+	 */
+	bool doorkeeper_contains(uint64_t hash) const;
+
+	/**
+	 * Halves all the counters and clears the doorkeeper
+	 */
+	void reset();
+
+	/**
+	 * Spreads the bits of a key
+	 * @param key the key
+	 * @return the key hash
+	 */
+	static uint64_t hash(uint64_t key);
+};
+
+#endif //CACHEFS_FREQUENCYSKETCH_H
@@ -0,0 +1,145 @@
+#include "GDSFPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+GDSFPolicy::GDSFPolicy(Block* pool) : CachePolicy(pool), _first_id(0), _inflation(0)
+{
+}
+
+/**
+ * Allocates the heap, the costs and the credits
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int GDSFPolicy::init(const PolicyConfig& config)
+{
+	_first_id = config.first_id;
+	_inflation = 0;
+	try
+	{
+		_heap.clear();
+		_heap.reserve((size_t)config.capacity);
+		_cost.assign((size_t)config.capacity, 1);
+		_credit.assign((size_t)config.capacity, 0);
+		_heap_position.assign((size_t)config.capacity, -1);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Appends the blocks from the highest credit to the lowest
+ * @param ids the vector to append the ids to
+ */
+void GDSFPolicy::order(std::vector<int>& ids) const
+{
+	size_t first = ids.size();
+	ids.insert(ids.end(), _heap.begin(), _heap.end());
+	std::sort(ids.begin() + first, ids.end(), [this](int lhs, int rhs)
+	{
+		return _credit[lhs - _first_id] > _credit[rhs - _first_id];
+	});
+}
+
+/**
+ * Adds a new block with a reference count of 1, its credit is L plus its cost
+ * @param block the new block
+ */
+void GDSFPolicy::insert(Block& block)
+{
+	int index = block.id - _first_id;
+	block.reference_num = 1;
+	_credit[index] = _inflation + _cost[index];
+	_heap.push_back(block.id);
+	heap_set((int)_heap.size() - 1, block.id);
+	sift_up((int)_heap.size() - 1);
+}
+
+/**
+ * Returns the heap root, when it's pinned the block with the lowest credit of the blocks that aren't pinned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int GDSFPolicy::victim() const
+{
+	if (_heap.empty())
+		return -1;
+	if (_pool[_heap[0]].pin_count == 0)
+		return _heap[0];
+
+	int victim_id = -1;
+	for (int id : _heap)
+		if (_pool[id].pin_count == 0 && (victim_id == -1 || _credit[id - _first_id] < _credit[victim_id - _first_id]))
+			victim_id = id;
+	return victim_id;
+}
+
+/**
+ * Removes the block from the heap, L becomes the credit of the block if it's the root,
+ * so L never passes the lowest credit
+ * @param block a cached block
+ */
+void GDSFPolicy::remove(Block& block)
+{
+	int index = block.id - _first_id;
+	int position = _heap_position[index];
+	if (position == 0)
+		_inflation = _credit[index];
+	_heap_position[index] = -1;
+
+	int last = _heap.back();
+	_heap.pop_back();
+	if (position == (int)_heap.size())
+		return;
+	heap_set(position, last);
+	sift_up(position);
+	sift_down(_heap_position[last - _first_id]);
+}
+
+/**
+ * Moves the block at a heap position up while its credit is lower than its parent's
+ * @param position the heap position
+ */
+void GDSFPolicy::sift_up(int position)
+{
+	int id = _heap[position];
+	double credit = _credit[id - _first_id];
+	while (position > 0)
+	{
+		int parent = (position - 1)/2;
+		if (heap_credit(parent) <= credit)
+			break;
+		heap_set(position, _heap[parent]);
+		position = parent;
+	}
+	heap_set(position, id);
+}
+
+/**
+ * Moves the block at a heap position down while its credit is higher than one of its children's
+ * @param position the heap position
+ */
+void GDSFPolicy::sift_down(int position)
+{
+	int size = (int)_heap.size();
+	int id = _heap[position];
+	double credit = _credit[id - _first_id];
+	while (true)
+	{
+		int child = 2*position + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && heap_credit(child + 1) < heap_credit(child))
+			child++;
+		if (heap_credit(child) >= credit)
+			break;
+		heap_set(position, _heap[child]);
+		position = child;
+	}
+	heap_set(position, id);
+}
@@ -0,0 +1,126 @@
+#ifndef CACHEFS_GDSFPOLICY_H
+#define CACHEFS_GDSFPOLICY_H
+
+#include <vector>
+#include "CachePolicy.h"
+
+/**
+ * GreedyDual-Size-Frequency. Every block has a credit, the inflation value L plus its reference count
+ * times the cost of reading it again, which is the average time it took to read a block of its file.
+ * The block with the lowest credit is evicted and its credit becomes the new L, so blocks that weren't accessed
+ * for a while lose to newer blocks. All the blocks have the same size, so the size term is left out.
+ * Blocks of files on slow devices survive longer than blocks that are as popular on fast devices.
+ */
+class GDSFPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit GDSFPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+
+	/**
+	 * The credits depend on the blocks miss cost
+	 */
+	static const bool USES_COST = true;
+
+	/**
+	 * Adds a new block with a reference count of 1
+	 */
+	void insert(Block& block);
+
+	/**
+	 * Increments the block reference count and raises its credit
+	 */
+	void access(Block& block)
+	{
+		int index = block.id - _first_id;
+		block.reference_num++;
+		_credit[index] = _inflation + (double)block.reference_num*_cost[index];
+		sift_down(_heap_position[index]);
+	}
+
+	/**
+	 * Sets the block cost, the credit of a block in the heap is recomputed with it
+	 */
+	void cost_changed(Block& block, double cost)
+	{
+		int index = block.id - _first_id;
+		_cost[index] = cost;
+		if (_heap_position[index] == -1)
+			return;
+		_credit[index] = _inflation + (double)block.reference_num*cost;
+		sift_up(_heap_position[index]);
+		sift_down(_heap_position[index]);
+	}
+
+	/**
+	 * Returns the block with the lowest credit that isn't pinned, -1 if all the blocks are pinned
+	 */
+	int victim() const;
+
+	/**
+	 * Removes the block, L becomes the credit of the block if it has the lowest credit
+	 */
+	void remove(Block& block);
+
+private:
+	/**
+	 * A binary min heap of the block ids ordered by credit
+	 */
+	std::vector<int> _heap;
+
+	/**
+	 * The block costs, credits and heap positions, parallel to the shard's part of the block array
+	 */
+	std::vector<double> _cost;
+	std::vector<double> _credit;
+	std::vector<int> _heap_position;
+
+	/**
+	 * The first block id of the shard
+	 */
+	int _first_id;
+
+	/**
+	 * The inflation value L, the credit of the last evicted block
+	 */
+	double _inflation;
+
+	/**
+	 * Returns the credit of the block at a heap position
+	 * @param position the heap position
+	 */
+	double heap_credit(int position) const
+	{
+		return _credit[_heap[position] - _first_id];
+	}
+
+	/**
+	 * Places a block id at a heap position
+	 * @param position the heap position
+	 * @param id the block id
+	 */
+	void heap_set(int position, int id)
+	{
+		_heap[position] = id;
+		_heap_position[id - _first_id] = position;
+	}
+
+	/**
+	 * Moves the block at a heap position up while its credit is lower than its parent's
+	 * @param position the heap position
+	 */
+	void sift_up(int position);
+
+	/**
+	 * Moves the block at a heap position down while its credit is higher than one of its children's
+	 * @param position the heap position
+	 */
+	void sift_down(int position);
+};
+
+#endif //CACHEFS_GDSFPOLICY_H
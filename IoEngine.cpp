@@ -0,0 +1,298 @@
+#include "IoEngine.h"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+/**
+ * The tag of the request that stops the completion thread
+ */
+#define STOP_TAG UINT64_MAX
+
+/**
+ * The max size of a single registered buffer
+ */
+#define MAX_FIXED_SIZE ((size_t)1 << 30)
+
+/**
+ * Default constructor, creates an inactive engine
+ */
+IoEngine::IoEngine() : _ring_fd(-1), _sq_ring(MAP_FAILED), _sq_ring_size(0), _cq_ring(MAP_FAILED), _cq_ring_size(0),
+					   _sqes((io_uring_sqe*) MAP_FAILED), _sqes_size(0), _sq_head(nullptr), _sq_tail(nullptr),
+					   _sq_mask(nullptr), _sq_array(nullptr), _sq_entries(0), _cq_head(nullptr), _cq_tail(nullptr),
+					   _cq_mask(nullptr), _cqes(nullptr), _cq_entries(0), _arena(nullptr), _fixed_size(-1),
+					   _to_submit(0), _inflight(0), _handler(nullptr) {}
+
+/**
+ * Destructor
+ */
+IoEngine::~IoEngine()
+{
+	destroy();
+}
+
+/**
+ * Sets up the io_uring instance, registers the buffers arena and starts the completion thread
+ * The arena is registered in parts of up to MAX_FIXED_SIZE bytes, if it can't be registered
+ * (e.g. because of the locked memory limit) the reads are done without fixed buffers
+ * @param arena the buffers arena, reads are done into buffers inside of it
+ * @param arena_size the arena size in bytes
+ * @param buffer_size the size of a single buffer in the arena
+ * @param entries the max number of reads in flight
+ * @param handler the completion handler
+ * @return 0 if successful, otherwise -1 and the engine stays inactive.
+ */
+int IoEngine::init(void* arena, size_t arena_size, size_t buffer_size, unsigned entries, CompletionHandler handler)
+{
+	destroy();
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	_ring_fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+	if (_ring_fd == -1)
+		return -1;
+
+	// map the rings, on newer kernels both rings share a single mapping
+	_sq_ring_size = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+	_cq_ring_size = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		_sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+
+	_sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+					IORING_OFF_SQ_RING);
+	if (_sq_ring == MAP_FAILED)
+	{
+		release_ring();
+		return -1;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		_cq_ring = _sq_ring;
+	else
+	{
+		_cq_ring = mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+						IORING_OFF_CQ_RING);
+		if (_cq_ring == MAP_FAILED)
+		{
+			release_ring();
+			return -1;
+		}
+	}
+	_sqes_size = params.sq_entries*sizeof(io_uring_sqe);
+	_sqes = (io_uring_sqe*) mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+								 IORING_OFF_SQES);
+	if (_sqes == MAP_FAILED)
+	{
+		release_ring();
+		return -1;
+	}
+
+	char* sq_ptr = (char*) _sq_ring;
+	_sq_head = (unsigned*)(sq_ptr + params.sq_off.head);
+	_sq_tail = (unsigned*)(sq_ptr + params.sq_off.tail);
+	_sq_mask = (unsigned*)(sq_ptr + params.sq_off.ring_mask);
+	_sq_array = (unsigned*)(sq_ptr + params.sq_off.array);
+	_sq_entries = params.sq_entries;
+
+	char* cq_ptr = (char*) _cq_ring;
+	_cq_head = (unsigned*)(cq_ptr + params.cq_off.head);
+	_cq_tail = (unsigned*)(cq_ptr + params.cq_off.tail);
+	_cq_mask = (unsigned*)(cq_ptr + params.cq_off.ring_mask);
+	_cqes = (io_uring_cqe*)(cq_ptr + params.cq_off.cqes);
+	_cq_entries = params.cq_entries;
+
+	// register the arena in parts that hold a whole number of buffers
+	_arena = (char*) arena;
+	size_t part_size = std::max(MAX_FIXED_SIZE - MAX_FIXED_SIZE % buffer_size, buffer_size);
+	std::vector<struct iovec> parts;
+	for (size_t start = 0; start < arena_size; start += part_size)
+	{
+		struct iovec part;
+		part.iov_base = _arena + start;
+		part.iov_len = std::min(part_size, arena_size - start);
+		parts.push_back(part);
+	}
+	if (syscall(__NR_io_uring_register, _ring_fd, IORING_REGISTER_BUFFERS, parts.data(), parts.size()) == 0)
+		_fixed_size = part_size;
+
+	_handler = handler;
+	_completion_thread = std::thread(&IoEngine::reap_completions, this);
+	return 0;
+}
+
+/**
+ * Waits for the reads in flight, stops the completion thread and releases the io_uring instance
+ */
+void IoEngine::destroy()
+{
+	if (_ring_fd == -1)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		enter_submit();
+		_completed.wait(lock, [this] { return _inflight == 0; });
+
+		// the stop request is always the last completion
+		io_uring_sqe* sqe = next_sqe();
+		sqe->opcode = IORING_OP_NOP;
+		sqe->user_data = STOP_TAG;
+		enter_submit();
+	}
+	_completion_thread.join();
+
+	release_ring();
+}
+
+/**
+ * Returns true if the engine can queue reads
+ */
+bool IoEngine::active() const
+{
+	return _ring_fd != -1;
+}
+
+/**
+ * Queues a read, the read is started by the next call to submit
+ * @param fd file descriptor
+ * @param iov the buffers to read into, inside the arena, must stay valid until the read completes
+ * @param iovcnt the number of buffers
+ * @param offset the file offset
+ * @param tag passed to the completion handler
+ * @return true if the read was queued, false if the engine is inactive or full
+ */
+bool IoEngine::queue_read(int fd, const struct iovec* iov, int iovcnt, off_t offset, uint64_t tag)
+{
+	if (_ring_fd == -1)
+		return false;
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	// keep a submission queue entry for the stop request, and never overflow the completion queue
+	unsigned queued = *_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+	if (queued + 1 >= _sq_entries || _inflight + 1 >= _cq_entries)
+		return false;
+
+	io_uring_sqe* sqe = next_sqe();
+	sqe->fd = fd;
+	sqe->off = (uint64_t) offset;
+	sqe->user_data = tag;
+	if (iovcnt == 1 && _fixed_size != -1)
+	{
+		sqe->opcode = IORING_OP_READ_FIXED;
+		sqe->addr = (uint64_t)(uintptr_t) iov[0].iov_base;
+		sqe->len = (uint32_t) iov[0].iov_len;
+		sqe->buf_index = (uint16_t)(((char*) iov[0].iov_base - _arena)/_fixed_size);
+	}
+	else
+	{
+		sqe->opcode = IORING_OP_READV;
+		sqe->addr = (uint64_t)(uintptr_t) iov;
+		sqe->len = (uint32_t) iovcnt;
+	}
+
+	_inflight++;
+	return true;
+}
+
+/**
+ * Starts all the queued reads
+ */
+void IoEngine::submit()
+{
+	if (_ring_fd == -1)
+		return;
+
+	std::lock_guard<std::mutex> lock(_lock);
+	enter_submit();
+}
+
+/**
+ * Queues a request, must be called with the lock held and a free submission queue entry
+ * @return the request submission queue entry
+ */
+io_uring_sqe* IoEngine::next_sqe()
+{
+	unsigned tail = *_sq_tail;
+	unsigned index = tail & *_sq_mask;
+	io_uring_sqe* sqe = &_sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	_sq_array[index] = index;
+
+	// the kernel reads the entry on the next io_uring_enter, which is also called with the lock held
+	__atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+	_to_submit++;
+	return sqe;
+}
+
+/**
+ * Submits the queued requests, must be called with the lock held
+ * Requests that the kernel didn't take stay queued for the next submit
+ */
+void IoEngine::enter_submit()
+{
+	while (_to_submit > 0)
+	{
+		long ret = syscall(__NR_io_uring_enter, _ring_fd, _to_submit, 0, 0, nullptr, 0);
+		if (ret <= 0)
+			return;
+		_to_submit -= (unsigned) ret;
+	}
+}
+
+/**
+ * The completion thread loop, returns when the stop request completes
+ */
+void IoEngine::reap_completions()
+{
+	while (true)
+	{
+		unsigned head = *_cq_head;
+		if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE))
+		{
+			syscall(__NR_io_uring_enter, _ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			continue;
+		}
+
+		io_uring_cqe* cqe = &_cqes[head & *_cq_mask];
+		uint64_t tag = cqe->user_data;
+		int result = cqe->res;
+		__atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+
+		if (tag == STOP_TAG)
+			return;
+
+		// taking the lock also orders the handler after the code that queued the read
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_inflight--;
+			_completed.notify_all();
+		}
+		_handler(tag, result < 0 ? -1 : result);
+	}
+}
+
+/**
+ * Unmaps the rings and closes the io_uring file descriptor
+ */
+void IoEngine::release_ring()
+{
+	if (_sqes != MAP_FAILED)
+		munmap(_sqes, _sqes_size);
+	if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring)
+		munmap(_cq_ring, _cq_ring_size);
+	if (_sq_ring != MAP_FAILED)
+		munmap(_sq_ring, _sq_ring_size);
+	close(_ring_fd);
+
+	_sqes = (io_uring_sqe*) MAP_FAILED;
+	_cq_ring = MAP_FAILED;
+	_sq_ring = MAP_FAILED;
+	_ring_fd = -1;
+	_to_submit = 0;
+	_inflight = 0;
+	_fixed_size = -1;
+}
@@ -0,0 +1,169 @@
+#ifndef CACHEFS_IOENGINE_H
+#define CACHEFS_IOENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * Asynchronous read engine built on an io_uring instance.
+ * The cache buffers arena is registered as fixed buffers, reads are queued by any thread and
+ * a background thread reaps the completions and passes them to the completion handler.
+ * A read into a single buffer uses the fixed buffers, a read into several buffers is a vectored read.
+ * When io_uring isn't available the engine is inactive and the callers read synchronously.
+ */
+class IoEngine {
+public:
+	/**
+	 * Called by the completion thread for every completed read
+	 * @param tag the tag the read was queued with
+	 * @param result the number of bytes read, -1 if the read failed
+	 */
+	typedef void (*CompletionHandler)(uint64_t tag, ssize_t result);
+
+	/**
+	 * Default constructor, creates an inactive engine
+	 */
+	IoEngine();
+
+	/**
+	 * Destructor
+	 */
+	~IoEngine();
+
+	/**
+	 * Sets up the io_uring instance, registers the buffers arena and starts the completion thread
+	 * @param arena the buffers arena, reads are done into buffers inside of it
+	 * @param arena_size the arena size in bytes
+	 * @param buffer_size the size of a single buffer in the arena
+	 * @param entries the max number of reads in flight
+	 * @param handler the completion handler
+	 * @return 0 if successful, otherwise -1 and the engine stays inactive.
+	 */
+	int init(void* arena, size_t arena_size, size_t buffer_size, unsigned entries, CompletionHandler handler);
+
+	/**
+	 * Waits for the reads in flight, stops the completion thread and releases the io_uring instance
+	 */
+	void destroy();
+
+	/**
+	 * Returns true if the engine can queue reads
+	 */
+	bool active() const;
+
+	/**
+	 * Queues a read, the read is started by the next call to submit
+	 * @param fd file descriptor
+	 * @param iov the buffers to read into, inside the arena, must stay valid until the read completes
+	 * @param iovcnt the number of buffers
+	 * @param offset the file offset
+	 * @param tag passed to the completion handler
+	 * @return true if the read was queued, false if the engine is inactive or full
+	 */
+	bool queue_read(int fd, const struct iovec* iov, int iovcnt, off_t offset, uint64_t tag);
+
+	/**
+	 * Starts all the queued reads
+	 */
+	void submit();
+
+	IoEngine(const IoEngine&) = delete;
+	IoEngine& operator=(const IoEngine&) = delete;
+
+private:
+	/**
+	 * The io_uring file descriptor, -1 if the engine is inactive
+	 */
+	int _ring_fd;
+
+	/**
+	 * The mapped rings and their sizes
+	 */
+	void* _sq_ring;
+	size_t _sq_ring_size;
+	void* _cq_ring;
+	size_t _cq_ring_size;
+	io_uring_sqe* _sqes;
+	size_t _sqes_size;
+
+	/**
+	 * Submission queue fields inside the mapped ring
+	 */
+	unsigned* _sq_head;
+	unsigned* _sq_tail;
+	unsigned* _sq_mask;
+	unsigned* _sq_array;
+	unsigned _sq_entries;
+
+	/**
+	 * Completion queue fields inside the mapped ring
+	 */
+	unsigned* _cq_head;
+	unsigned* _cq_tail;
+	unsigned* _cq_mask;
+	io_uring_cqe* _cqes;
+	unsigned _cq_entries;
+
+	/**
+	 * The registered arena, and the size of each registered part of it, -1 if the arena isn't registered
+	 */
+	char* _arena;
+	ssize_t _fixed_size;
+
+	/**
+	 * Protects the submission queue and the counters
+	 */
+	std::mutex _lock;
+
+	/**
+	 * Notified whenever a read completes
+	 */
+	std::condition_variable _completed;
+
+	/**
+	 * The number of queued reads that weren't submitted yet
+	 */
+	unsigned _to_submit;
+
+	/**
+	 * The number of queued reads that didn't complete yet
+	 */
+	unsigned _inflight;
+
+	/**
+	 * Reaps the completions
+	 */
+	std::thread _completion_thread;
+	CompletionHandler _handler;
+
+	/**
+	 * Queues a request, must be called with the lock held and a free submission queue entry
+	 * @return the request submission queue entry
+	 */
+	io_uring_sqe* next_sqe();
+
+	/**
+	 * Submits the queued requests, must be called with the lock held
+	 */
+	void enter_submit();
+
+	/**
+	 * The completion thread loop, returns when the stop request completes
+	 */
+	void reap_completions();
+
+	/**
+	 * Unmaps the rings and closes the io_uring file descriptor
+	 */
+	void release_ring();
+};
+
+#endif //CACHEFS_IOENGINE_H
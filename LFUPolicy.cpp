@@ -0,0 +1,147 @@
+#include "LFUPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+LFUPolicy::LFUPolicy(Block* pool) : CachePolicy(pool), _head(-1), _tail(-1), _accesses(0), _decay_period(0),
+									 _decay_bucket(-1) {}
+
+/**
+ * Allocates a bucket per block and a spare one, the counts are halved after DECAY_PERIOD accesses per block
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int LFUPolicy::init(const PolicyConfig& config)
+{
+	try
+	{
+		_buckets.resize(config.capacity + 1);
+		_free_buckets.clear();
+		_free_buckets.reserve(config.capacity + 1);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+
+	for (int bucket_id = config.capacity; bucket_id >= 0; --bucket_id)
+	{
+		_buckets[bucket_id].blocks.init(_pool, bucket_id);
+		_free_buckets.push_back(bucket_id);
+	}
+	_head = -1;
+	_tail = -1;
+	_accesses = 0;
+	_decay_period = DECAY_PERIOD*(size_t)config.capacity;
+	_decay_bucket = -1;
+	return 0;
+}
+
+/**
+ * Appends the blocks from the highest reference count bucket, each bucket from its end
+ * @param ids the vector to append the ids to
+ */
+void LFUPolicy::order(std::vector<int>& ids) const
+{
+	for (int bucket_id = _tail; bucket_id != -1; bucket_id = _buckets[bucket_id].prev)
+		for (int id = _buckets[bucket_id].blocks.tail(); id != -1; id = _pool[id].prev)
+			ids.push_back(id);
+}
+
+/**
+ * Returns the least frequently used block that isn't pinned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int LFUPolicy::victim() const
+{
+	// the least recently used block with the lowest reference count
+	for (int bucket_id = _head; bucket_id != -1; bucket_id = _buckets[bucket_id].next)
+		for (int id = _buckets[bucket_id].blocks.head(); id != -1; id = _pool[id].next)
+			if (_pool[id].pin_count == 0)
+				return id;
+	return -1;
+}
+
+/**
+ * Creates an empty bucket
+ * @param prev_bucket the bucket after which the new bucket is inserted, -1 to insert it first
+ * @param reference_num the reference count of the new bucket
+ * @return the new bucket id
+ */
+int LFUPolicy::bucket_create(int prev_bucket, size_t reference_num)
+{
+	int bucket_id = _free_buckets.back();
+	_free_buckets.pop_back();
+
+	FreqBucket& bucket = _buckets[bucket_id];
+	bucket.reference_num = reference_num;
+	bucket.prev = prev_bucket;
+	bucket.next = (prev_bucket == -1) ? _head : _buckets[prev_bucket].next;
+
+	if (bucket.prev == -1)
+		_head = bucket_id;
+	else
+		_buckets[bucket.prev].next = bucket_id;
+	if (bucket.next == -1)
+		_tail = bucket_id;
+	else
+		_buckets[bucket.next].prev = bucket_id;
+
+	return bucket_id;
+}
+
+/**
+ * Unlinks an empty bucket and returns it to the unused buckets
+ * @param bucket_id the bucket id
+ */
+void LFUPolicy::bucket_release(int bucket_id)
+{
+	FreqBucket& bucket = _buckets[bucket_id];
+	if (_decay_bucket == bucket_id)
+		_decay_bucket = bucket.next;
+	if (bucket.prev == -1)
+		_head = bucket.next;
+	else
+		_buckets[bucket.prev].next = bucket.next;
+	if (bucket.next == -1)
+		_tail = bucket.prev;
+	else
+		_buckets[bucket.next].prev = bucket.prev;
+	_free_buckets.push_back(bucket_id);
+}
+
+/**
+ * Halves the counts of the next few buckets, a halving starts when there were enough accesses since the last one.
+ * The counts are at least 1, and a bucket whose halved count isn't higher than the count of the bucket before it
+ * is merged into it, a few blocks at a time, its blocks become the most recently used blocks of that bucket
+ * The buckets that were halved and the buckets that weren't are both in increasing count order, and every halved
+ * count is lower than the counts that weren't halved, so accesses in the middle of a halving keep the order
+ */
+void LFUPolicy::decay_step()
+{
+	if (_decay_bucket == -1)
+	{
+		_accesses = 0;
+		_decay_bucket = _head;
+	}
+
+	for (int work = 0; work < DECAY_STEP_WORK && _decay_bucket != -1; ++work)
+	{
+		FreqBucket& bucket = _buckets[_decay_bucket];
+		size_t halved = std::max(bucket.reference_num/2, (size_t)1);
+		if (bucket.prev == -1 || _buckets[bucket.prev].reference_num < halved)
+		{
+			bucket.reference_num = halved;
+			_decay_bucket = bucket.next;
+			continue;
+		}
+
+		// the last block moved releases the bucket, and the next bucket is halved next
+		Block& block = _pool[bucket.blocks.head()];
+		FreqBucket& prev_bucket = _buckets[bucket.prev];
+		remove(block);
+		prev_bucket.blocks.push_back(block);
+	}
+}
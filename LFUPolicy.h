@@ -0,0 +1,155 @@
+#ifndef CACHEFS_LFUPOLICY_H
+#define CACHEFS_LFUPOLICY_H
+
+#include <stddef.h>
+#include <vector>
+#include "BlockList.h"
+#include "CachePolicy.h"
+
+/**
+ * Least frequently used, the blocks are kept in frequency buckets ordered by increasing reference count,
+ * blocks with the same reference count are ordered from the least recently used to the most recently used
+ * The least recently used block of the first bucket is the next block to be evicted
+ * The reference counts age, after every DECAY_PERIOD accesses per block all the counts are halved, so blocks that
+ * were popular a long time ago don't outrank the current working set. Halving keeps the buckets order, so it's done
+ * incrementally, a few buckets on every access, from the lowest count bucket, merging buckets whose counts meet.
+ */
+class LFUPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit LFUPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+
+	/**
+	 * A new block is referenced for the first time
+	 */
+	void insert(Block& block)
+	{
+		access(block);
+	}
+
+	/**
+	 * Moves the given block to the end of the bucket of its new reference count, the count of the bucket
+	 * the block is in, which might have been halved, plus one
+	 */
+	void access(Block& block)
+	{
+		block.reference_num = (block.list == -1 ? 0 : _buckets[block.list].reference_num) + 1;
+
+		// the bucket of the new reference count is right after the current bucket if it exists
+		int prev_bucket = block.list;
+		int bucket_id = (prev_bucket == -1) ? _head : _buckets[prev_bucket].next;
+		if (bucket_id == -1 || _buckets[bucket_id].reference_num != block.reference_num)
+			bucket_id = bucket_create(prev_bucket, block.reference_num);
+
+		// remove block from its current bucket and add it as the most recently used block of the new one
+		if (block.list != -1)
+			remove(block);
+		_buckets[bucket_id].blocks.push_back(block);
+
+		if (_decay_bucket != -1 || ++_accesses >= _decay_period)
+			decay_step();
+	}
+
+	/**
+	 * Returns the least recently used block with the lowest reference count that isn't pinned,
+	 * -1 if all the blocks are pinned
+	 */
+	int victim() const;
+
+	/**
+	 * Removes a block from its bucket, the bucket is released when it becomes empty
+	 */
+	void remove(Block& block)
+	{
+		int bucket_id = block.list;
+		FreqBucket& bucket = _buckets[bucket_id];
+		bucket.blocks.remove(block);
+		if (bucket.blocks.size() == 0)
+			bucket_release(bucket_id);
+	}
+
+private:
+	/**
+	 * The number of accesses per block between halvings of the reference counts
+	 */
+	static const size_t DECAY_PERIOD = 16;
+
+	/**
+	 * The max number of buckets halved or blocks moved to a merged bucket on every access while counts are halved
+	 */
+	static const int DECAY_STEP_WORK = 4;
+
+	/**
+	 * A bucket of all the blocks with the same reference count
+	 */
+	struct FreqBucket {
+		/**
+		 * The reference count of the blocks in the bucket
+		 */
+		size_t reference_num;
+
+		/**
+		 * The bucket blocks, the list id is the bucket id
+		 */
+		BlockList blocks;
+
+		/**
+		 * The buckets with the next lower and the next higher reference count, -1 if there isn't one
+		 */
+		int prev, next;
+	};
+
+	/**
+	 * The frequency buckets, there is at most one bucket per block and a spare one
+	 */
+	std::vector<FreqBucket> _buckets;
+
+	/**
+	 * Unused cells of buckets
+	 */
+	std::vector<int> _free_buckets;
+
+	/**
+	 * The buckets with the lowest and the highest reference count
+	 */
+	int _head;
+	int _tail;
+
+	/**
+	 * The accesses since the last halving started, and the number of accesses that starts the next halving
+	 */
+	size_t _accesses;
+	size_t _decay_period;
+
+	/**
+	 * The next bucket to halve, the buckets before it were halved already, -1 when the counts aren't being halved
+	 */
+	int _decay_bucket;
+
+	/**
+	 * Creates an empty bucket
+	 * @param prev_bucket the bucket after which the new bucket is inserted, -1 to insert it first
+	 * @param reference_num the reference count of the new bucket
+	 * @return the new bucket id
+	 */
+	int bucket_create(int prev_bucket, size_t reference_num);
+
+	/**
+	 * Unlinks an empty bucket and returns it to the unused buckets
+	 * @param bucket_id the bucket id
+	 */
+	void bucket_release(int bucket_id);
+
+	/**
+	 * Halves the counts of the next few buckets
+	 */
+	void decay_step();
+};
+
+#endif //CACHEFS_LFUPOLICY_H
@@ -0,0 +1,263 @@
+#include "LIRSPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+LIRSPolicy::LIRSPolicy(Block* pool) : CachePolicy(pool), _first_id(0), _lir_capacity(0), _lir_count(0), _non_resident_capacity(0)
+{
+	_queue.init(pool, 0);
+	_stack = EntryList{-1, -1, 0};
+	_non_resident = EntryList{-1, -1, 0};
+}
+
+/**
+ * Allocates the entries pool and the block entries, 1% of the cache (at least one block) is kept for HIR blocks
+ * and S holds at most capacity non resident entries
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int LIRSPolicy::init(const PolicyConfig& config)
+{
+	_queue.init(_pool, 0);
+	_stack = EntryList{-1, -1, 0};
+	_non_resident = EntryList{-1, -1, 0};
+	_lir_capacity = config.capacity - std::max(config.capacity/100, 1);
+	_lir_count = 0;
+	_non_resident_capacity = config.capacity;
+	_first_id = config.first_id;
+
+	try
+	{
+		_block_entries.assign((size_t)config.capacity, -1);
+		_entries.resize(2*(size_t)config.capacity);
+		_free_entries.clear();
+		_free_entries.reserve(2*(size_t)config.capacity);
+		_non_resident_index.clear();
+		_non_resident_index.reserve(config.capacity);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	for (int entry_id = 2*config.capacity - 1; entry_id >= 0; --entry_id)
+		_free_entries.push_back(entry_id);
+	return 0;
+}
+
+/**
+ * Appends the LIR blocks from the top of S to its bottom, and then the HIR blocks from the end of the queue
+ * @param ids the vector to append the ids to
+ */
+void LIRSPolicy::order(std::vector<int>& ids) const
+{
+	for (int entry_id = _stack.tail; entry_id != -1; entry_id = _entries[entry_id].prev)
+		if (_entries[entry_id].lir)
+			ids.push_back(_entries[entry_id].block_id);
+	for (int id = _queue.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+}
+
+/**
+ * Releases the non resident entries of a closed file
+ * @param file_id the closed file
+ */
+void LIRSPolicy::forget(int file_id)
+{
+	int entry_id = _non_resident.head;
+	while (entry_id != -1)
+	{
+		int next = _entries[entry_id].nr_next;
+		if ((uint32_t)(_entries[entry_id].key >> 32) == (uint32_t)file_id)
+			entry_release(entry_id);
+		entry_id = next;
+	}
+}
+
+/**
+ * Adds a new block, while there is room for LIR blocks it's a LIR block,
+ * otherwise a block with a non resident entry in S is promoted to LIR and any other block is a HIR block
+ * @param block the new block
+ */
+void LIRSPolicy::insert(Block& block)
+{
+	uint64_t key = block_key(block);
+	auto entry_iter = _non_resident_index.find(key);
+	if (entry_iter != _non_resident_index.end())
+	{
+		// the entry becomes resident again
+		int entry_id = entry_iter->second;
+		Entry& entry = _entries[entry_id];
+		_non_resident_index.erase(entry_iter);
+		if (entry.nr_prev == -1)
+			_non_resident.head = entry.nr_next;
+		else
+			_entries[entry.nr_prev].nr_next = entry.nr_next;
+		if (entry.nr_next == -1)
+			_non_resident.tail = entry.nr_prev;
+		else
+			_entries[entry.nr_next].nr_prev = entry.nr_prev;
+		_non_resident.size--;
+
+		entry.block_id = block.id;
+		block_entry(block.id) = entry_id;
+		_queue.push_back(block);
+		promote(block);
+	}
+	else if (_lir_count < _lir_capacity)
+	{
+		block_entry(block.id) = entry_create(key, block.id, true);
+		_lir_count++;
+	}
+	else
+	{
+		block_entry(block.id) = entry_create(key, block.id, false);
+		_queue.push_back(block);
+	}
+}
+
+/**
+ * Returns the first HIR block of the queue that isn't pinned,
+ * when all of them are pinned the LIR block closest to the bottom of S that isn't pinned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int LIRSPolicy::victim() const
+{
+	for (int id = _queue.head(); id != -1; id = _pool[id].next)
+		if (_pool[id].pin_count == 0)
+			return id;
+	for (int entry_id = _stack.head; entry_id != -1; entry_id = _entries[entry_id].next)
+	{
+		const Entry& entry = _entries[entry_id];
+		if (entry.lir && _pool[entry.block_id].pin_count == 0)
+			return entry.block_id;
+	}
+	return -1;
+}
+
+/**
+ * Removes the block, the key of a HIR block that is in S stays in S as a non resident entry,
+ * the oldest non resident entry is released when there are too many of them
+ * @param block a cached block
+ */
+void LIRSPolicy::remove(Block& block)
+{
+	int entry_id = block_entry(block.id);
+	if (!_queue.contains(block))
+	{
+		// a LIR block is removed only when all the HIR blocks are pinned or its file is closed
+		bool bottom = _stack.head == entry_id;
+		_lir_count--;
+		entry_release(entry_id);
+		if (bottom)
+			prune();
+		return;
+	}
+
+	_queue.remove(block);
+	if (entry_id == -1)
+		return;
+
+	if (_non_resident.size >= _non_resident_capacity)
+		entry_release(_non_resident.head);
+
+	Entry& entry = _entries[entry_id];
+	entry.block_id = -1;
+	block_entry(block.id) = -1;
+	entry.nr_prev = _non_resident.tail;
+	entry.nr_next = -1;
+	if (_non_resident.tail == -1)
+		_non_resident.head = entry_id;
+	else
+		_entries[_non_resident.tail].nr_next = entry_id;
+	_non_resident.tail = entry_id;
+	_non_resident.size++;
+	_non_resident_index[entry.key] = entry_id;
+}
+
+/**
+ * Creates an entry at the top of S
+ * @param key the block key
+ * @param block_id the cached block
+ * @param lir true if the block is a LIR block
+ * @return the entry
+ */
+int LIRSPolicy::entry_create(uint64_t key, int block_id, bool lir)
+{
+	int entry_id = _free_entries.back();
+	_free_entries.pop_back();
+
+	Entry& entry = _entries[entry_id];
+	entry.key = key;
+	entry.block_id = block_id;
+	entry.lir = lir;
+	entry.nr_prev = -1;
+	entry.nr_next = -1;
+	stack_push(entry_id);
+	return entry_id;
+}
+
+/**
+ * Removes an entry from S and releases it
+ * @param entry_id the entry
+ */
+void LIRSPolicy::entry_release(int entry_id)
+{
+	Entry& entry = _entries[entry_id];
+	stack_remove(entry_id);
+
+	if (entry.block_id != -1)
+		block_entry(entry.block_id) = -1;
+	else
+	{
+		_non_resident_index.erase(entry.key);
+		if (entry.nr_prev == -1)
+			_non_resident.head = entry.nr_next;
+		else
+			_entries[entry.nr_prev].nr_next = entry.nr_next;
+		if (entry.nr_next == -1)
+			_non_resident.tail = entry.nr_prev;
+		else
+			_entries[entry.nr_next].nr_prev = entry.nr_prev;
+		_non_resident.size--;
+	}
+
+	_free_entries.push_back(entry_id);
+}
+
+/**
+ * Makes a HIR block that is in S a LIR block and moves it to the top of S,
+ * when there are too many LIR blocks the LIR block at the bottom of S becomes a HIR block
+ * @param block a resident HIR block with an entry in S
+ */
+void LIRSPolicy::promote(Block& block)
+{
+	int entry_id = block_entry(block.id);
+	_entries[entry_id].lir = true;
+	_lir_count++;
+	_queue.remove(block);
+	stack_remove(entry_id);
+	stack_push(entry_id);
+	// without other LIR blocks the bottom of S may be a HIR entry
+	prune();
+
+	if (_lir_count > _lir_capacity)
+	{
+		Entry& bottom = _entries[_stack.head];
+		bottom.lir = false;
+		_lir_count--;
+		_queue.push_back(_pool[bottom.block_id]);
+		prune();
+	}
+}
+
+/**
+ * Removes the HIR entries at the bottom of S, so the bottom of S is a LIR block
+ * Each entry is pruned once after it's pushed, so the cost is constant amortized
+ */
+void LIRSPolicy::prune()
+{
+	while (_stack.head != -1 && !_entries[_stack.head].lir)
+		entry_release(_stack.head);
+}
@@ -0,0 +1,238 @@
+#ifndef CACHEFS_LIRSPOLICY_H
+#define CACHEFS_LIRSPOLICY_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "BlockList.h"
+#include "CachePolicy.h"
+
+/**
+ * Low inter-reference recency set. Most of the cache holds the LIR blocks, the blocks that were accessed again
+ * soon after their previous access, and a small part holds the HIR blocks, which are evicted first in FIFO order.
+ * The recency stack S orders the recently accessed keys, including keys of HIR blocks that were evicted,
+ * a block that is accessed while its key is still in S becomes LIR and the LIR block at the bottom of S becomes HIR.
+ * The bottom of S is always a LIR block, the HIR entries under it are pruned.
+ * A loop over slightly more blocks than the cache keeps the LIR blocks cached, where LRU misses every block.
+ */
+class LIRSPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit LIRSPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+	void forget(int file_id) override;
+
+	/**
+	 * Adds a new block, as LIR while there is room for LIR blocks or if its key is in S, otherwise as HIR
+	 */
+	void insert(Block& block);
+
+	/**
+	 * Moves the block to the top of S, a HIR block that is in S becomes LIR
+	 */
+	void access(Block& block)
+	{
+		int entry_id = block_entry(block.id);
+		if (!_queue.contains(block))
+		{
+			// a LIR block is always in S
+			bool bottom = _stack.head == entry_id;
+			stack_remove(entry_id);
+			stack_push(entry_id);
+			if (bottom)
+				prune();
+		}
+		else if (entry_id != -1)
+			promote(block);
+		else
+		{
+			// a HIR block that isn't in S stays HIR and moves to the end of the queue
+			block_entry(block.id) = entry_create(block_key(block), block.id, false);
+			_queue.remove(block);
+			_queue.push_back(block);
+		}
+	}
+
+	/**
+	 * Returns the first HIR block of the queue that isn't pinned,
+	 * when all of them are pinned the LIR block at the bottom of S that isn't pinned,
+	 * -1 if all the blocks are pinned
+	 */
+	int victim() const;
+
+	/**
+	 * Removes the block, the key of a HIR block that is in S stays in S as a non resident entry
+	 */
+	void remove(Block& block);
+
+private:
+	/**
+	 * An entry of S
+	 */
+	struct Entry {
+		/**
+		 * The block key
+		 */
+		uint64_t key;
+
+		/**
+		 * The cached block, -1 if the entry isn't resident
+		 */
+		int block_id;
+
+		/**
+		 * True if the block is a LIR block
+		 */
+		bool lir;
+
+		/**
+		 * The neighbours in S, prev is closer to the bottom
+		 */
+		int prev, next;
+
+		/**
+		 * The neighbours in the non resident entries list, ordered by the time the entries became non resident
+		 */
+		int nr_prev, nr_next;
+	};
+
+	/**
+	 * The ends of an entries list
+	 */
+	struct EntryList {
+		int head, tail;
+		int size;
+	};
+
+	/**
+	 * The resident HIR blocks, the head is the next block to be evicted
+	 */
+	BlockList _queue;
+
+	/**
+	 * The entries pool, there are at most capacity resident and capacity non resident entries, and the unused entries
+	 */
+	std::vector<Entry> _entries;
+	std::vector<int> _free_entries;
+
+	/**
+	 * The entry of every block, -1 for a HIR block that isn't in S, parallel to the shard's part of the block array
+	 */
+	std::vector<int> _block_entries;
+
+	/**
+	 * The first block id of the shard
+	 */
+	int _first_id;
+
+	/**
+	 * The stack S, the head is the bottom
+	 */
+	EntryList _stack;
+
+	/**
+	 * The non resident entries of S, the head is the oldest
+	 */
+	EntryList _non_resident;
+
+	/**
+	 * Maps the key of a non resident entry to the entry
+	 */
+	std::unordered_map<uint64_t, int> _non_resident_index;
+
+	/**
+	 * The max number of LIR blocks, and the current number of LIR blocks
+	 */
+	int _lir_capacity;
+	int _lir_count;
+
+	/**
+	 * The max number of non resident entries
+	 */
+	int _non_resident_capacity;
+
+	/**
+	 * Returns the entry of a block
+	 * @param block_id the block id
+	 */
+	int& block_entry(int block_id)
+	{
+		return _block_entries[block_id - _first_id];
+	}
+
+	/**
+	 * Returns the key of a block
+	 */
+	static uint64_t block_key(const Block& block)
+	{
+		return ((uint64_t)(uint32_t)block.file_id << 32) | (uint32_t)block.block_num;
+	}
+
+	/**
+	 * Adds an entry to the top of S
+	 * @param entry_id the entry
+	 */
+	void stack_push(int entry_id)
+	{
+		Entry& entry = _entries[entry_id];
+		entry.prev = _stack.tail;
+		entry.next = -1;
+		if (_stack.tail == -1)
+			_stack.head = entry_id;
+		else
+			_entries[_stack.tail].next = entry_id;
+		_stack.tail = entry_id;
+		_stack.size++;
+	}
+
+	/**
+	 * Removes an entry from S
+	 * @param entry_id the entry
+	 */
+	void stack_remove(int entry_id)
+	{
+		Entry& entry = _entries[entry_id];
+		if (entry.prev == -1)
+			_stack.head = entry.next;
+		else
+			_entries[entry.prev].next = entry.next;
+		if (entry.next == -1)
+			_stack.tail = entry.prev;
+		else
+			_entries[entry.next].prev = entry.prev;
+		_stack.size--;
+	}
+
+	/**
+	 * Creates an entry at the top of S
+	 * @param key the block key
+	 * @param block_id the cached block
+	 * @param lir true if the block is a LIR block
+	 * @return the entry
+	 */
+	int entry_create(uint64_t key, int block_id, bool lir);
+
+	/**
+	 * Removes an entry from S and releases it
+	 * @param entry_id the entry
+	 */
+	void entry_release(int entry_id);
+
+	/**
+	 * Makes a HIR block that is in S a LIR block, and the LIR block at the bottom of S a HIR block
+	 * @param block a resident HIR block with an entry in S
+	 */
+	void promote(Block& block);
+
+	/**
+	 * Removes the HIR entries at the bottom of S, so the bottom of S is a LIR block
+	 */
+	void prune();
+};
+
+#endif //CACHEFS_LIRSPOLICY_H
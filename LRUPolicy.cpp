@@ -0,0 +1,44 @@
+#include "LRUPolicy.h"
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+LRUPolicy::LRUPolicy(Block* pool) : CachePolicy(pool)
+{
+	_queue.init(pool, 0);
+}
+
+/**
+ * Initializes an empty queue
+ * @param config the algorithm parameters
+ * @return 0
+ */
+int LRUPolicy::init(const PolicyConfig& config)
+{
+	(void) config;
+	_queue.init(_pool, 0);
+	return 0;
+}
+
+/**
+ * Appends the blocks from the end of the queue to its head
+ * @param ids the vector to append the ids to
+ */
+void LRUPolicy::order(std::vector<int>& ids) const
+{
+	for (int id = _queue.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+}
+
+/**
+ * Returns the least recently used block that isn't pinned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int LRUPolicy::victim() const
+{
+	int id = _queue.head();
+	while (id != -1 && _pool[id].pin_count > 0)
+		id = _pool[id].next;
+	return id;
+}
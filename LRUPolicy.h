@@ -0,0 +1,59 @@
+#ifndef CACHEFS_LRUPOLICY_H
+#define CACHEFS_LRUPOLICY_H
+
+#include "BlockList.h"
+#include "CachePolicy.h"
+
+/**
+ * Least recently used, the blocks are kept in a queue ordered by their last access
+ * The head is the next block to be evicted, the tail is the last block to be evicted
+ */
+class LRUPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit LRUPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+
+	/**
+	 * A new block is the most recently used block
+	 */
+	void insert(Block& block)
+	{
+		_queue.push_back(block);
+	}
+
+	/**
+	 * Moves the block to the end of the queue
+	 */
+	void access(Block& block)
+	{
+		_queue.remove(block);
+		_queue.push_back(block);
+	}
+
+	/**
+	 * Returns the least recently used block that isn't pinned, -1 if all the blocks are pinned
+	 */
+	int victim() const;
+
+	/**
+	 * Removes the block from the queue
+	 */
+	void remove(Block& block)
+	{
+		_queue.remove(block);
+	}
+
+private:
+	/**
+	 * The block queue
+	 */
+	BlockList _queue;
+};
+
+#endif //CACHEFS_LRUPOLICY_H
@@ -0,0 +1,164 @@
+#include "S3FIFOPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+S3FIFOPolicy::S3FIFOPolicy(Block* pool) : CachePolicy(pool), _first_id(0), _small_capacity(0), _ghost_sequence(0)
+{
+	_small.init(pool, LIST_SMALL);
+	_main.init(pool, LIST_MAIN);
+}
+
+/**
+ * Allocates the access counters and the ghost queue, the ghost queue holds as many keys as the main queue blocks
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int S3FIFOPolicy::init(const PolicyConfig& config)
+{
+	_small.init(_pool, LIST_SMALL);
+	_main.init(_pool, LIST_MAIN);
+	_first_id = config.first_id;
+	_small_capacity = std::max(config.capacity/10, 1);
+	_ghost_sequence = 0;
+
+	size_t ghost_capacity = (size_t)std::max(config.capacity - _small_capacity, 1);
+	try
+	{
+		_frequency.assign((size_t)config.capacity, 0);
+		_ghost_ring.assign(ghost_capacity, 0);
+		_ghost_index.clear();
+		_ghost_index.reserve(ghost_capacity);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Appends the main queue blocks and then the small queue blocks, each queue from its end
+ * @param ids the vector to append the ids to
+ */
+void S3FIFOPolicy::order(std::vector<int>& ids) const
+{
+	for (int id = _main.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+	for (int id = _small.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+}
+
+/**
+ * Removes the keys of a closed file from the ghost queue, their ring slots are left to be overwritten
+ * @param file_id the closed file
+ */
+void S3FIFOPolicy::forget(int file_id)
+{
+	for (auto ghost_iter = _ghost_index.begin(); ghost_iter != _ghost_index.end();)
+	{
+		if ((uint32_t)(ghost_iter->first >> 32) == (uint32_t)file_id)
+			ghost_iter = _ghost_index.erase(ghost_iter);
+		else
+			ghost_iter++;
+	}
+}
+
+/**
+ * Adds a new block with a clear access counter, a block whose key is in the ghost queue was evicted
+ * from the small queue too early, so it's added to the main queue and its key leaves the ghost queue
+ * @param block the new block
+ */
+void S3FIFOPolicy::insert(Block& block)
+{
+	_frequency[block.id - _first_id] = 0;
+
+	auto ghost_iter = _ghost_index.find(block_key(block));
+	if (ghost_iter != _ghost_index.end())
+	{
+		_ghost_index.erase(ghost_iter);
+		_main.push_back(block);
+	}
+	else
+		_small.push_back(block);
+}
+
+/**
+ * Evicts from the small queue while it's full or the main queue is empty, otherwise from the main queue.
+ * A small queue head that was accessed moves to the main queue, a main queue head that was accessed moves to
+ * the end of the main queue with a lower counter, and a pinned head moves to the end of its queue.
+ * When the queues can't give a block this way, any block that isn't pinned is returned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int S3FIFOPolicy::victim()
+{
+	// a counter reaches 0 after at most 3 passes over the main queue
+	int steps = 5*(_small.size() + _main.size());
+	for (int step = 0; step < steps; ++step)
+	{
+		bool from_small = _small.size() > 0 && (_small.size() >= _small_capacity || _main.size() == 0);
+		BlockList& queue = from_small ? _small : _main;
+		if (queue.size() == 0)
+			break;
+
+		Block& block = _pool[queue.head()];
+		uint8_t& frequency = _frequency[block.id - _first_id];
+		if (frequency > 0)
+		{
+			if (from_small)
+				requeue(_small, _main);
+			else
+			{
+				frequency--;
+				requeue(_main, _main);
+			}
+		}
+		else if (block.pin_count > 0)
+			requeue(queue, queue);
+		else
+			return block.id;
+	}
+
+	for (const BlockList* queue : {&_small, &_main})
+		for (int id = queue->head(); id != -1; id = _pool[id].next)
+			if (_pool[id].pin_count == 0)
+				return id;
+	return -1;
+}
+
+/**
+ * Removes the block from its queue, the key of a small queue block enters the ghost queue
+ * @param block a cached block
+ */
+void S3FIFOPolicy::remove(Block& block)
+{
+	if (_small.contains(block))
+	{
+		_small.remove(block);
+		ghost_push(block_key(block));
+	}
+	else
+		_main.remove(block);
+}
+
+/**
+ * Adds a key to the ghost queue, the key it overwrites in the ring leaves the index
+ * unless it was added again since then
+ * @param key the block key
+ */
+void S3FIFOPolicy::ghost_push(uint64_t key)
+{
+	uint64_t ghost_capacity = _ghost_ring.size();
+	uint64_t slot = _ghost_sequence % ghost_capacity;
+	if (_ghost_sequence >= ghost_capacity)
+	{
+		auto ghost_iter = _ghost_index.find(_ghost_ring[slot]);
+		if (ghost_iter != _ghost_index.end() && ghost_iter->second == _ghost_sequence - ghost_capacity)
+			_ghost_index.erase(ghost_iter);
+	}
+	_ghost_ring[slot] = key;
+	_ghost_index[key] = _ghost_sequence;
+	_ghost_sequence++;
+}
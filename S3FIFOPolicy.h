@@ -0,0 +1,121 @@
+#ifndef CACHEFS_S3FIFOPOLICY_H
+#define CACHEFS_S3FIFOPOLICY_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "BlockList.h"
+#include "CachePolicy.h"
+
+/**
+ * S3-FIFO, three FIFO queues. New blocks enter the small queue, 10% of the cache (at least one block),
+ * and the rest of the cache is the main queue. A block that leaves the small queue moves to the main queue
+ * if it was accessed while it was there, otherwise it's evicted and its key enters the ghost queue.
+ * A missing block whose key is in the ghost queue is added to the main queue. The main queue is a clock
+ * over 2-bit access counters, a block at its head that was accessed goes back to its end with a lower count.
+ * A hit only increments the block's counter, the queues are changed on the miss path only.
+ */
+class S3FIFOPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit S3FIFOPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+	void forget(int file_id) override;
+
+	/**
+	 * Adds a new block to the end of the main queue if its key is in the ghost queue, otherwise to the small queue
+	 */
+	void insert(Block& block);
+
+	/**
+	 * Increments the block access counter, up to 3
+	 */
+	void access(Block& block)
+	{
+		uint8_t& frequency = _frequency[block.id - _first_id];
+		if (frequency < 3)
+			frequency++;
+	}
+
+	/**
+	 * Moves the accessed blocks from the queue heads until it reaches a block to evict and returns it,
+	 * -1 if all the blocks are pinned
+	 */
+	int victim();
+
+	/**
+	 * Removes the block from its queue, the key of a small queue block enters the ghost queue
+	 */
+	void remove(Block& block);
+
+private:
+	/**
+	 * The list ids
+	 */
+	enum ListId {
+		LIST_SMALL = 1,
+		LIST_MAIN = 2
+	};
+
+	/**
+	 * The small and main queues, the head is the oldest block
+	 */
+	BlockList _small;
+	BlockList _main;
+
+	/**
+	 * The access counters, parallel to the shard's part of the block array
+	 */
+	std::vector<uint8_t> _frequency;
+
+	/**
+	 * The first block id of the shard
+	 */
+	int _first_id;
+
+	/**
+	 * The max number of blocks in the small queue
+	 */
+	int _small_capacity;
+
+	/**
+	 * The ghost queue, a ring of the last evicted keys. A key is in the queue if the index maps it to
+	 * the sequence number it was added with and the ring wasn't overwritten since then
+	 */
+	std::vector<uint64_t> _ghost_ring;
+	std::unordered_map<uint64_t, uint64_t> _ghost_index;
+	uint64_t _ghost_sequence;
+
+	/**
+	 * Returns the key of a block
+	 */
+	static uint64_t block_key(const Block& block)
+	{
+		return ((uint64_t)(uint32_t)block.file_id << 32) | (uint32_t)block.block_num;
+	}
+
+	/**
+	 * Adds a key to the ghost queue, the oldest key leaves it when the ring is full
+	 * @param key the block key
+	 */
+	void ghost_push(uint64_t key);
+
+	/**
+	 * Moves a block from the head of its queue to the end of another queue
+	 * @param from the block queue
+	 * @param to the new queue
+	 */
+	void requeue(BlockList& from, BlockList& to)
+	{
+		Block& block = _pool[from.head()];
+		from.remove(block);
+		to.push_back(block);
+	}
+};
+
+#endif //CACHEFS_S3FIFOPOLICY_H
@@ -0,0 +1,144 @@
+#include "SampledPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ * @param lfu true if the score is the access count, otherwise it's the last access time
+ */
+SampledPolicy::SampledPolicy(Block* pool, bool lfu) : CachePolicy(pool), _lfu(lfu), _first_id(0), _clock(0),
+													  _candidates_num(0), _random(0x9e3779b97f4a7c15ULL)
+{
+}
+
+/**
+ * Allocates the slot scores
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int SampledPolicy::init(const PolicyConfig& config)
+{
+	_first_id = config.first_id;
+	_clock = 0;
+	_candidates_num = 0;
+	try
+	{
+		_score.assign((size_t)config.capacity, 0);
+	} catch (std::bad_alloc& e)
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Appends the cached blocks from the highest score to the lowest
+ * The blocks are evicted by samples, so this is only the order they would be evicted in if all of them were sampled
+ * @param ids the vector to append the ids to
+ */
+void SampledPolicy::order(std::vector<int>& ids) const
+{
+	size_t first = ids.size();
+	for (int slot = 0; slot < (int)_score.size(); ++slot)
+		if (_score[slot] != 0)
+			ids.push_back(_first_id + slot);
+	std::sort(ids.begin() + first, ids.end(), [this](int lhs, int rhs)
+	{
+		return _score[lhs - _first_id] > _score[rhs - _first_id];
+	});
+}
+
+/**
+ * Samples slots into the candidates pool, drops the candidates that aren't valid anymore
+ * and returns the remaining candidate with the lowest score.
+ * When there are no candidates, the slots are scanned for the lowest score that isn't pinned
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int SampledPolicy::victim()
+{
+	for (int i = 0; i < SAMPLES; ++i)
+	{
+		int slot = random_slot();
+		if (_score[slot] != 0 && _pool[_first_id + slot].pin_count == 0)
+			candidate_add(_first_id + slot);
+	}
+
+	int kept = 0;
+	for (int i = 0; i < _candidates_num; ++i)
+		if (candidate_valid(_candidates[i]))
+			_candidates[kept++] = _candidates[i];
+	_candidates_num = kept;
+	if (_candidates_num > 0)
+		return _candidates[0].id;
+
+	int victim_id = -1;
+	for (int slot = 0; slot < (int)_score.size(); ++slot)
+	{
+		if (_score[slot] == 0 || _pool[_first_id + slot].pin_count > 0)
+			continue;
+		if (victim_id == -1 || _score[slot] < _score[victim_id - _first_id])
+			victim_id = _first_id + slot;
+	}
+	return victim_id;
+}
+
+/**
+ * Returns a random slot of the shard, from a xorshift generator
+ * @return the slot index
+ */
+int SampledPolicy::random_slot()
+{
+	_random ^= _random >> 12;
+	_random ^= _random << 25;
+	_random ^= _random >> 27;
+	return (int)(((_random*0x2545f4914f6cdd1dULL) >> 32) % _score.size());
+}
+
+/**
+ * Adds a sampled block to the candidates pool in its score order, an older candidate of the same block is replaced
+ * When the pool is full the worst candidate leaves it, unless the block is worse than all of them
+ * @param id the block id
+ */
+void SampledPolicy::candidate_add(int id)
+{
+	for (int i = 0; i < _candidates_num; ++i)
+	{
+		if (_candidates[i].id != id)
+			continue;
+		for (int j = i + 1; j < _candidates_num; ++j)
+			_candidates[j - 1] = _candidates[j];
+		_candidates_num--;
+		break;
+	}
+
+	uint64_t score = _score[id - _first_id];
+	if (_candidates_num == CANDIDATES)
+	{
+		if (score >= _candidates[CANDIDATES - 1].score)
+			return;
+		_candidates_num--;
+	}
+
+	int position = _candidates_num;
+	while (position > 0 && _candidates[position - 1].score > score)
+	{
+		_candidates[position] = _candidates[position - 1];
+		position--;
+	}
+	const Block& block = _pool[id];
+	_candidates[position] = Candidate{id, block.file_id, block.block_num, score};
+	_candidates_num++;
+}
+
+/**
+ * Returns true if a candidate still describes its slot, the slot holds the same block with the same score,
+ * and the block isn't pinned
+ * @param candidate the candidate
+ */
+bool SampledPolicy::candidate_valid(const Candidate& candidate) const
+{
+	const Block& block = _pool[candidate.id];
+	return _score[candidate.id - _first_id] == candidate.score && block.file_id == candidate.file_id &&
+		   block.block_num == candidate.block_num && block.pin_count == 0;
+}
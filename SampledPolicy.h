@@ -0,0 +1,149 @@
+#ifndef CACHEFS_SAMPLEDPOLICY_H
+#define CACHEFS_SAMPLEDPOLICY_H
+
+#include <stdint.h>
+#include <vector>
+#include "CachePolicy.h"
+
+/**
+ * Sampled eviction, for caches that are too big to keep ordered. Every slot of the shard's part of the block array
+ * has a single score, the last access time for LRU or the access count for LFU, and a hit only updates it.
+ * To evict, a few random slots are sampled and the ones with the lowest scores join a small pool of candidates
+ * that carries over to the next evictions, and the best candidate that is still valid is evicted.
+ */
+class SampledPolicy : public CachePolicy {
+public:
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+
+	/**
+	 * Gives the new block its first score
+	 */
+	void insert(Block& block)
+	{
+		_score[block.id - _first_id] = _lfu ? 1 : ++_clock;
+	}
+
+	/**
+	 * Updates the block score
+	 */
+	void access(Block& block)
+	{
+		uint64_t& score = _score[block.id - _first_id];
+		score = _lfu ? score + 1 : ++_clock;
+	}
+
+	/**
+	 * Samples slots into the candidates pool and returns the candidate with the lowest score,
+	 * -1 if all the blocks are pinned
+	 */
+	int victim();
+
+	/**
+	 * Clears the block slot
+	 */
+	void remove(Block& block)
+	{
+		_score[block.id - _first_id] = 0;
+	}
+
+protected:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 * @param lfu true if the score is the access count, otherwise it's the last access time
+	 */
+	SampledPolicy(Block* pool, bool lfu);
+
+private:
+	/**
+	 * The number of slots sampled for every eviction, and the max number of candidates
+	 */
+	static const int SAMPLES = 5;
+	static const int CANDIDATES = 16;
+
+	/**
+	 * A block that may be evicted, with its key and score when it was sampled,
+	 * it isn't valid anymore if its slot was accessed or reused since then
+	 */
+	struct Candidate {
+		int id;
+		int file_id;
+		int block_num;
+		uint64_t score;
+	};
+
+	/**
+	 * True if the score is the access count, otherwise it's the last access time
+	 */
+	bool _lfu;
+
+	/**
+	 * The slot scores, parallel to the shard's part of the block array, 0 for an empty slot
+	 */
+	std::vector<uint64_t> _score;
+
+	/**
+	 * The first block id of the shard
+	 */
+	int _first_id;
+
+	/**
+	 * The access time of the last accessed block, for LRU
+	 */
+	uint64_t _clock;
+
+	/**
+	 * The candidates pool, ordered by score from the lowest
+	 */
+	Candidate _candidates[CANDIDATES];
+	int _candidates_num;
+
+	/**
+	 * The random generator state
+	 */
+	uint64_t _random;
+
+	/**
+	 * Returns a random slot of the shard
+	 */
+	int random_slot();
+
+	/**
+	 * Adds a sampled block to the candidates pool if it's better than the worst candidate or the pool isn't full
+	 * @param id the block id
+	 */
+	void candidate_add(int id);
+
+	/**
+	 * Returns true if a candidate still describes its slot and can be evicted
+	 * @param candidate the candidate
+	 */
+	bool candidate_valid(const Candidate& candidate) const;
+};
+
+/**
+ * Sampled eviction of the least recently used block
+ */
+class SampledLRUPolicy final : public SampledPolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit SampledLRUPolicy(Block* pool) : SampledPolicy(pool, false) {}
+};
+
+/**
+ * Sampled eviction of the least frequently used block
+ */
+class SampledLFUPolicy final : public SampledPolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit SampledLFUPolicy(Block* pool) : SampledPolicy(pool, true) {}
+};
+
+#endif //CACHEFS_SAMPLEDPOLICY_H
@@ -5,7 +5,16 @@
 #include <fstream>
 #include <iostream>
 #include <sys/stat.h>
+#include <stdint.h>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstring>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
 #include "CacheFS.h"
 
 void sanityCheck()
@@ -754,6 +763,1429 @@ void stressTest()
 
 }
 
+void multiThreadRead()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/threads1.txt");
+    for (unsigned int i=0; i<64*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    // big enough to be split into several shards
+    CacheFS_init(4096, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/threads1.txt");
+
+    const int threadsNum = 4;
+    const int rounds = 100;
+    std::vector<std::thread> threads;
+    std::vector<int> results(threadsNum, 1);
+    for (int t = 0; t < threadsNum; t++)
+    {
+        threads.push_back(std::thread([&, t]() {
+            std::vector<char> data(blockSize);
+            for (int r = 0; r < rounds; r++)
+            {
+                for (int b = 0; b < 64; b++)
+                {
+                    int block = (b + t*16) % 64; // each thread starts from a different block
+                    int ret = CacheFS_pread(fd1, data.data(), blockSize, block*blockSize);
+                    if (ret != (int)blockSize || data[0] != (char)('a' + block%26) ||
+                        data[blockSize - 1] != (char)('a' + block%26))
+                    {
+                        results[t] = 0;
+                    }
+                }
+            }
+        }));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (int result : results)
+    {
+        if (!result) {ok = false;}
+    }
+
+    std::ofstream eraser;
+    eraser.open("/tmp/threads_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    // review stats, every block is read from the file once:
+    CacheFS_print_stat("/tmp/threads_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/threads_stats.txt");
+    char statsResults[10000] = "\0";
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(statsResults, 10000);
+
+        std::string expected = "Hits number: " + std::to_string(threadsNum*rounds*64 - 64) + "\nMisses number: 64\n";
+        if (strcmp(statsResults, expected.c_str())) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "Multi Thread Read Passed!\n";
+    }
+    else
+    {
+        std::cout << "Multi Thread Read Failed!\n";
+    }
+}
+
+void clockProThreadTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/threads2.txt");
+    for (unsigned int i=0; i<64*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    // smaller than the file, so the hits that don't take the shard lock race with evictions
+    CacheFS_init(48, CLOCKPRO, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/threads2.txt");
+
+    const int threadsNum = 4;
+    const int rounds = 100;
+    std::vector<std::thread> threads;
+    std::vector<int> results(threadsNum, 1);
+    for (int t = 0; t < threadsNum; t++)
+    {
+        threads.push_back(std::thread([&, t]() {
+            std::vector<char> data(blockSize);
+            for (int r = 0; r < rounds; r++)
+            {
+                for (int b = 0; b < 64; b++)
+                {
+                    // most reads go to the first 32 blocks
+                    int block = b%2 ? (b*7 + t*5 + r) % 32 : (b + t*16 + r) % 64;
+                    int ret = CacheFS_pread(fd1, data.data(), blockSize, block*blockSize);
+                    if (ret != (int)blockSize || data[0] != (char)('a' + block%26) ||
+                        data[blockSize - 1] != (char)('a' + block%26))
+                    {
+                        results[t] = 0;
+                    }
+                }
+            }
+        }));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (int result : results)
+    {
+        if (!result) {ok = false;}
+    }
+
+    std::ofstream eraser;
+    eraser.open("/tmp/threads_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    // review stats, every read is either a hit or a miss:
+    CacheFS_print_stat("/tmp/threads_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/threads_stats.txt");
+    int hits = -1, misses = -1;
+    if (resultsFileInput.is_open()) {
+        std::string line;
+        while (std::getline(resultsFileInput, line))
+        {
+            sscanf(line.c_str(), "Hits number: %d", &hits);
+            sscanf(line.c_str(), "Misses number: %d", &misses);
+        }
+        if (hits + misses != threadsNum*rounds*64 || misses < 64) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "CLOCK-Pro Thread Read Passed!\n";
+    }
+    else
+    {
+        std::cout << "CLOCK-Pro Thread Read Failed!\n";
+    }
+}
+
+void clockProHotHitsTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/threads3.txt");
+    for (unsigned int i=0; i<512*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    // the hot blocks fit in the cache, the scanned blocks don't
+    CacheFS_init(64, CLOCKPRO, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/threads3.txt");
+
+    const int hittersNum = 4;
+    const int rounds = 20;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    std::vector<int> results(hittersNum + 1, 1);
+    for (int t = 0; t < hittersNum; t++)
+    {
+        // keep hitting the hot blocks without the shard lock while the scan evicts
+        threads.push_back(std::thread([&, t]() {
+            std::vector<char> data(blockSize);
+            for (int i = 0; !done; i++)
+            {
+                int block = (i + t*8) % 32;
+                int ret = CacheFS_pread(fd1, data.data(), blockSize, block*blockSize);
+                if (ret != (int)blockSize || data[0] != (char)('a' + block%26) ||
+                    data[blockSize - 1] != (char)('a' + block%26))
+                {
+                    results[t] = 0;
+                }
+            }
+        }));
+    }
+    threads.push_back(std::thread([&]() {
+        std::vector<char> data(blockSize);
+        for (int r = 0; r < rounds; r++)
+        {
+            for (int block = 32; block < 512; block++)
+            {
+                int ret = CacheFS_pread(fd1, data.data(), blockSize, block*blockSize);
+                if (ret != (int)blockSize || data[0] != (char)('a' + block%26))
+                {
+                    results[hittersNum] = 0;
+                }
+            }
+        }
+        done = true;
+    }));
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (int result : results)
+    {
+        if (!result) {ok = false;}
+    }
+
+    std::ofstream eraser;
+    eraser.open("/tmp/threads_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    // review stats, every scanned block is a miss:
+    CacheFS_print_stat("/tmp/threads_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/threads_stats.txt");
+    int hits = -1, misses = -1;
+    if (resultsFileInput.is_open()) {
+        std::string line;
+        while (std::getline(resultsFileInput, line))
+        {
+            sscanf(line.c_str(), "Hits number: %d", &hits);
+            sscanf(line.c_str(), "Misses number: %d", &misses);
+        }
+        if (misses < rounds*480 || hits <= 0) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "CLOCK-Pro Hot Hits Passed!\n";
+    }
+    else
+    {
+        std::cout << "CLOCK-Pro Hot Hits Failed!\n";
+    }
+}
+
+void readaheadTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/readahead1.txt");
+    for (unsigned int i=0; i<40*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    CacheFS_init(64, LRU, 0.1, 0.1);
+    if (CacheFS_set_readahead(64) == 0) {ok = false;} // more than half of the cache
+    if (CacheFS_set_readahead(16) != 0) {ok = false;}
+    int fd1 = CacheFS_open("/tmp/readahead1.txt");
+
+    // stream the file in quarter blocks, only the first block should be a demand miss
+    char data[blockSize];
+    for (unsigned int offset = 0; offset < 40*blockSize; offset += blockSize/4)
+    {
+        int ret = CacheFS_pread(fd1, &data, blockSize/4, offset);
+        if (ret != (int)blockSize/4 || data[0] != (char)('a' + (offset/blockSize)%26)) {ok = false;}
+    }
+
+    std::ofstream eraser;
+    eraser.open("/tmp/readahead_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    // review stats:
+    CacheFS_print_stat("/tmp/readahead_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/readahead_stats.txt");
+    char statsResults[10000] = "\0";
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(statsResults, 10000);
+
+        if (strcmp(statsResults, "Hits number: 120\nMisses number: 1\nPrefetched blocks: 39\n"
+                                 "Prefetch hits: 39\nPrefetch wasted: 0\n")) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "Readahead Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Readahead Check Failed!\n";
+    }
+}
+
+void prefetchTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/prefetch1.txt");
+    for (unsigned int i=0; i<10*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    CacheFS_init(16, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/prefetch1.txt");
+
+    // prefetch past the end of the file, only the file blocks are prefetched
+    if (CacheFS_prefetch(fd1, 2*blockSize, 20*blockSize) != 0) {ok = false;}
+
+    // the reads wait for the prefetched blocks instead of reading them again
+    char data[blockSize];
+    for (unsigned int block = 0; block < 10; block++)
+    {
+        int ret = CacheFS_pread(fd1, &data, blockSize, block*blockSize);
+        if (ret != (int)blockSize || data[0] != (char)('a' + block%26)) {ok = false;}
+    }
+
+    std::ofstream eraser;
+    eraser.open("/tmp/prefetch_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    // review stats:
+    CacheFS_print_stat("/tmp/prefetch_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/prefetch_stats.txt");
+    char statsResults[10000] = "\0";
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(statsResults, 10000);
+
+        if (strcmp(statsResults, "Hits number: 0\nMisses number: 2\nPrefetched blocks: 8\n"
+                                 "Prefetch hits: 8\nPrefetch wasted: 0\n")) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "Prefetch Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Prefetch Check Failed!\n";
+    }
+}
+
+void prefetchEvictionTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/prefetch_eviction1.txt");
+    for (unsigned int i=0; i<100*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    // a prefetch bigger than the cache is cut to the cache size
+    CacheFS_init(16, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/prefetch_eviction1.txt");
+    if (CacheFS_prefetch(fd1, 0, 40*blockSize) != 0) {ok = false;}
+
+    std::ofstream eraser;
+    eraser.open("/tmp/prefetch_eviction_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    CacheFS_print_stat("/tmp/prefetch_eviction_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/prefetch_eviction_stats.txt");
+    char statsResults[10000] = "\0";
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(statsResults, 10000);
+
+        if (strcmp(statsResults, "Hits number: 0\nMisses number: 0\nPrefetched blocks: 16\n"
+                                 "Prefetch hits: 0\nPrefetch wasted: 0\n")) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    char data[blockSize];
+    for (unsigned int block = 0; block < 40; block++)
+    {
+        int ret = CacheFS_pread(fd1, &data, blockSize, block*blockSize);
+        if (ret != (int)blockSize || data[0] != (char)('a' + block%26)) {ok = false;}
+    }
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    // readahead on a full cache, the algorithms may choose to evict blocks that are still being prefetched
+    cache_algo_t algos[] = {LFU, ARC, LIRS, TINYLFU, CLOCKPRO, S3FIFO, SAMPLED_LFU};
+    for (cache_algo_t algo : algos)
+    {
+        CacheFS_init(64, algo, 0.1, 0.1);
+        if (CacheFS_set_readahead(16) != 0) {ok = false;}
+        fd1 = CacheFS_open("/tmp/prefetch_eviction1.txt");
+        for (int round = 0; round < 3; round++)
+        {
+            for (unsigned int offset = 0; offset < 100*blockSize; offset += blockSize/4)
+            {
+                int ret = CacheFS_pread(fd1, &data, blockSize/4, offset);
+                if (ret != (int)blockSize/4 || data[0] != (char)('a' + (offset/blockSize)%26)) {ok = false;}
+            }
+        }
+        CacheFS_close(fd1);
+        CacheFS_destroy();
+    }
+
+    if (ok)
+    {
+        std::cout << "Prefetch Eviction Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Prefetch Eviction Check Failed!\n";
+    }
+}
+
+void pinnedReadTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/pinned1.txt");
+    for (unsigned int i=0; i<4*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    CacheFS_init(2, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/pinned1.txt");
+
+    // view the end of block 0 and the start of block 1
+    cachefs_view_t views[4];
+    int viewsNum = CacheFS_pread_ref(fd1, views, 4, blockSize, blockSize/2);
+    if (viewsNum != 2 || views[0].size != blockSize/2 || views[1].size != blockSize/2 ||
+        ((const char*)views[0].data)[0] != 'a' || ((const char*)views[1].data)[blockSize/2 - 1] != 'b')
+    {
+        ok = false;
+    }
+
+    // all the cache blocks are pinned, nothing can be evicted
+    char data[blockSize];
+    if (CacheFS_pread(fd1, &data, 10, 2*blockSize) != -1) {ok = false;}
+    if (CacheFS_pread(fd1, &data, 10, 0) != 10 || data[0] != 'a') {ok = false;}
+
+    // after the release the blocks can be evicted again
+    if (CacheFS_release(views, viewsNum) != 0) {ok = false;}
+    if (CacheFS_pread(fd1, &data, 10, 3*blockSize) != 10 || data[0] != 'd') {ok = false;}
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "Pinned Read Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Pinned Read Check Failed!\n";
+    }
+}
+
+void vectoredReadTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/vectored1.txt");
+    for (unsigned int i=0; i<4*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+
+    std::ofstream eraser;
+    eraser.open("/tmp/vectored_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    CacheFS_init(4, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/vectored1.txt");
+
+    // a small header and a payload that crosses a block boundary, past the end of the file
+    char header[16];
+    char payload[3*blockSize];
+    struct iovec iov[3];
+    iov[0].iov_base = header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = payload;
+    iov[1].iov_len = 0;
+    iov[2].iov_base = payload;
+    iov[2].iov_len = sizeof(payload);
+    int ret = CacheFS_preadv(fd1, iov, 3, 2*blockSize - sizeof(header));
+    if (ret != (int)(sizeof(header) + 2*blockSize) || header[0] != 'b' || header[15] != 'b' ||
+        payload[0] != 'c' || payload[blockSize] != 'd' || payload[2*blockSize - 1] != 'd')
+    {
+        ok = false;
+    }
+
+    // review stats, every block is accessed once:
+    CacheFS_print_stat("/tmp/vectored_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/vectored_stats.txt");
+    char statsResults[10000] = "\0";
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(statsResults, 10000);
+
+        if (strcmp(statsResults, "Hits number: 0\nMisses number: 4\n")) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "Vectored Read Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Vectored Read Check Failed!\n";
+    }
+}
+
+void batchReadTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the files for the test, every block has its own letter:
+    std::ofstream outfile1 ("/tmp/batch1.txt");
+    for (unsigned int i=0; i<4*blockSize; i++)
+    {
+        outfile1 << (char)('a' + (i/blockSize)%26);
+    }
+    outfile1.close();
+    std::ofstream outfile2 ("/tmp/batch2.txt");
+    for (unsigned int i=0; i<4*blockSize; i++)
+    {
+        outfile2 << (char)('A' + (i/blockSize)%26);
+    }
+    outfile2.close();
+
+    std::ofstream eraser;
+    eraser.open("/tmp/batch_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    // the cache is smaller than the blocks of the batch
+    CacheFS_init(3, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/batch1.txt");
+    int fd2 = CacheFS_open("/tmp/batch2.txt");
+
+    char data[5][2*blockSize];
+    cachefs_read_t reads[5] = {
+        {fd1, data[0], 10, (off_t)(3*blockSize), 0},
+        {fd2, data[1], blockSize, (off_t)(blockSize/2), 0},
+        {fd1, data[2], 10, 10, 0},
+        {fd1, data[3], 10, (off_t)(3*blockSize + 20), 0},
+        {-5, data[4], 10, 0, 0}
+    };
+    if (CacheFS_pread_batch(reads, 5) != -1) {ok = false;}
+    if (reads[0].result != 10 || data[0][0] != 'd') {ok = false;}
+    if (reads[1].result != (int)blockSize || data[1][0] != 'A' || data[1][blockSize - 1] != 'B') {ok = false;}
+    if (reads[2].result != 10 || data[2][0] != 'a') {ok = false;}
+    if (reads[3].result != 10 || data[3][0] != 'd') {ok = false;}
+    if (reads[4].result != -1) {ok = false;}
+
+    // review stats, the block that is read by two requests is accessed once:
+    CacheFS_print_stat("/tmp/batch_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/batch_stats.txt");
+    char statsResults[10000] = "\0";
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(statsResults, 10000);
+
+        if (strcmp(statsResults, "Hits number: 0\nMisses number: 4\n")) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_close(fd2);
+    CacheFS_destroy();
+
+    if (ok)
+    {
+        std::cout << "Batch Read Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Batch Read Check Failed!\n";
+    }
+}
+
+void fileIdentityTest()
+{
+    bool ok = true;
+
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the file for the test, and a hard link to it:
+    std::ofstream outfile ("/tmp/identity_test.txt");
+    for (unsigned int i=0; i<2*blockSize; i++)
+    {
+        outfile << "I";
+    }
+    outfile.close();
+    unlink("/tmp/identity_link.txt");
+    link("/tmp/identity_test.txt", "/tmp/identity_link.txt");
+
+    // open the file under three different names, all of them share the same blocks:
+    CacheFS_init(10, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/identity_test.txt");
+    int fd2 = CacheFS_open("/tmp/./identity_test.txt");
+    int fd3 = CacheFS_open("/tmp/identity_link.txt");
+    if (fd1 < 0 || fd2 < 0 || fd3 < 0 || fd1 == fd2 || fd2 == fd3 || fd1 == fd3) {ok = false;}
+
+    char data[10];
+    CacheFS_pread(fd1, &data, 10, 0);
+    CacheFS_pread(fd2, &data, 10, 0);
+
+    // closing one name keeps the file open for the others:
+    CacheFS_close(fd1);
+    if (CacheFS_pread(fd3, &data, 10, 0) != 10 || data[0] != 'I') {ok = false;}
+    if (CacheFS_pread(fd1, &data, 10, 0) != -1) {ok = false;}
+
+    // check that we have one miss and two hits:
+    std::ofstream eraser;
+    eraser.open("/tmp/test_identity.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    char results[10000] = "\0";
+    CacheFS_print_stat("/tmp/test_identity.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/test_identity.txt");
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(results, 10000);
+        if (strcmp(results, "Hits number: 2\nMisses number: 1\n"))
+        {
+            ok = false;
+        }
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd2);
+    CacheFS_close(fd3);
+    CacheFS_destroy();
+    unlink("/tmp/identity_link.txt");
+
+    if (ok)
+    {
+        std::cout << "File Identity Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "File Identity Check Failed!\n";
+    }
+}
+
+/**
+ * Reads one byte of every block of the trace and returns the number of cache hits
+ */
+size_t traceHits(cache_algo_t algo, const std::vector<int>& trace, int blocksNum, const char* path, size_t blockSize)
+{
+    CacheFS_init(blocksNum, algo, 0.3, 0.3);
+    int fd = CacheFS_open(path);
+    char data;
+    for (int block : trace)
+    {
+        CacheFS_pread(fd, &data, 1, block*blockSize);
+    }
+
+    std::ofstream eraser;
+    eraser.open("/tmp/trace_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+    CacheFS_print_stat("/tmp/trace_stats.txt");
+    CacheFS_close(fd);
+    CacheFS_destroy();
+
+    size_t hits = 0;
+    std::ifstream resultsFileInput("/tmp/trace_stats.txt");
+    std::string word;
+    resultsFileInput >> word >> word >> hits;
+    return hits;
+}
+
+void closedFileHistoryTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create the files for the test:
+    std::ofstream outfile1 ("/tmp/history1.txt");
+    std::ofstream outfile2 ("/tmp/history2.txt");
+    for (unsigned int i=0; i<8*blockSize; i++)
+    {
+        outfile1 << '1';
+        outfile2 << '2';
+    }
+    outfile1.close();
+    outfile2.close();
+
+    // the second file gets the file descriptor of the first file once it's closed, the keys the algorithms keep
+    // of the first file's blocks must not turn its misses into hits
+    char data[blockSize];
+    cache_algo_t algos[] = {ARC, LIRS, CLOCKPRO, S3FIFO};
+    for (cache_algo_t algo : algos)
+    {
+        std::string results[2];
+        for (int run = 0; run < 2; run++)
+        {
+            CacheFS_init(4, algo, 0.1, 0.1);
+            if (run == 1)
+            {
+                int fd1 = CacheFS_open("/tmp/history1.txt");
+                for (unsigned int block = 0; block < 8; block++)
+                {
+                    CacheFS_pread(fd1, &data, blockSize, block*blockSize);
+                }
+                CacheFS_close(fd1);
+            }
+
+            int fd2 = CacheFS_open("/tmp/history2.txt");
+            int blocks[] = {4, 5, 0, 1, 2, 4, 5};
+            for (int block : blocks)
+            {
+                CacheFS_pread(fd2, &data, blockSize, block*blockSize);
+            }
+
+            std::ofstream eraser;
+            eraser.open("/tmp/history_log.txt", std::ofstream::out | std::ofstream::trunc);
+            eraser.close();
+            CacheFS_print_cache("/tmp/history_log.txt");
+            CacheFS_print_stat("/tmp/history_log.txt");
+            CacheFS_close(fd2);
+            CacheFS_destroy();
+
+            // the misses of the first file are left out
+            std::ifstream resultsFileInput("/tmp/history_log.txt");
+            std::string line;
+            while (std::getline(resultsFileInput, line))
+            {
+                if (line.compare(0, 6, "Misses") != 0)
+                {
+                    results[run] += line + "\n";
+                }
+            }
+        }
+        if (results[0] != results[1]) {ok = false;}
+    }
+
+    if (ok)
+    {
+        std::cout << "Closed File History Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Closed File History Check Failed!\n";
+    }
+}
+
+void farBlockTest()
+{
+    bool ok = true;
+
+    // get the block size:
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // create a sparse file of 1 TiB, the first and the last blocks have their own letters:
+    off_t fileSize = (off_t)1 << 40;
+    off_t lastBlock = fileSize - (off_t)blockSize;
+    std::ofstream outfile1 ("/tmp/far_block1.txt");
+    for (unsigned int i=0; i<blockSize; i++)
+    {
+        outfile1 << 'a';
+    }
+    outfile1.seekp(lastBlock);
+    for (unsigned int i=0; i<blockSize; i++)
+    {
+        outfile1 << 'z';
+    }
+    outfile1.close();
+
+    CacheFS_init(4, LRU, 0.1, 0.1);
+    int fd1 = CacheFS_open("/tmp/far_block1.txt");
+
+    // the blocks at both ends of the file are cached side by side
+    char data[blockSize];
+    for (int round = 0; round < 2; round++)
+    {
+        if (CacheFS_pread(fd1, &data, blockSize, lastBlock) != (int)blockSize || data[0] != 'z') {ok = false;}
+        if (CacheFS_pread(fd1, &data, blockSize, 0) != (int)blockSize || data[0] != 'a') {ok = false;}
+    }
+
+    std::ofstream eraser;
+    eraser.open("/tmp/far_block_stats.txt", std::ofstream::out | std::ofstream::trunc);
+    eraser.close();
+
+    // review stats:
+    CacheFS_print_stat("/tmp/far_block_stats.txt");
+    std::ifstream resultsFileInput;
+    resultsFileInput.open("/tmp/far_block_stats.txt");
+    char statsResults[10000] = "\0";
+    if (resultsFileInput.is_open()) {
+        resultsFileInput.read(statsResults, 10000);
+
+        if (strcmp(statsResults, "Hits number: 2\nMisses number: 2\n")) {ok = false;}
+    }
+    resultsFileInput.close();
+
+    CacheFS_close(fd1);
+    CacheFS_destroy();
+    unlink("/tmp/far_block1.txt");
+
+    if (ok)
+    {
+        std::cout << "Far Block Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Far Block Check Failed!\n";
+    }
+}
+
+void arcHitRatioTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<400*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    // a frequency phase, a hot set with a scan after every pass over it,
+    // and then a recency phase, a new working set that fits in the cache
+    std::vector<int> trace;
+    int scanBlock = 100;
+    for (int round = 0; round < 3; round++)
+    {
+        for (int block = 0; block < 4; block++)
+        {
+            trace.push_back(block);
+        }
+    }
+    for (int round = 0; round < 30; round++)
+    {
+        for (int block = 0; block < 4; block++)
+        {
+            trace.push_back(block);
+        }
+        for (int i = 0; i < 6; i++)
+        {
+            trace.push_back(scanBlock++);
+        }
+    }
+    for (int round = 0; round < 30; round++)
+    {
+        for (int block = 10; block < 16; block++)
+        {
+            trace.push_back(block);
+        }
+    }
+
+    size_t lruHits = traceHits(LRU, trace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t lfuHits = traceHits(LFU, trace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t fbrHits = traceHits(FBR, trace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t arcHits = traceHits(ARC, trace, 8, "/tmp/trace_test.txt", blockSize);
+
+    // ARC keeps the hot set during the scans like LFU, and adapts to the new working set like LRU
+
+    if (arcHits > lruHits && arcHits > lfuHits && arcHits >= fbrHits)
+    {
+        std::cout << "ARC Hit Ratio Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "ARC Hit Ratio Check Failed!\n";
+    }
+}
+
+void lirsLoopTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<400*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    // loop over a few more blocks than the cache has
+    std::vector<int> trace;
+    for (int round = 0; round < 20; round++)
+    {
+        for (int block = 0; block < 12; block++)
+        {
+            trace.push_back(block);
+        }
+    }
+
+    // LRU always evicts the block that is needed next, LIRS keeps most of the loop cached
+    size_t lruHits = traceHits(LRU, trace, 10, "/tmp/trace_test.txt", blockSize);
+    size_t lirsHits = traceHits(LIRS, trace, 10, "/tmp/trace_test.txt", blockSize);
+
+    // CLOCK-Pro approximates LIRS with a clock
+    size_t clockProHits = traceHits(CLOCKPRO, trace, 10, "/tmp/trace_test.txt", blockSize);
+
+    if (lruHits == 0 && lirsHits > trace.size()/2 && clockProHits > trace.size()/2)
+    {
+        std::cout << "LIRS Loop Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "LIRS Loop Check Failed!\n";
+    }
+}
+
+void tinyLfuScanTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<400*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    // a hot set, with a scan of blocks that are read once after every pass over it
+    std::vector<int> trace;
+    int scanBlock = 100;
+    for (int round = 0; round < 25; round++)
+    {
+        for (int block = 0; block < 4; block++)
+        {
+            trace.push_back(block);
+        }
+        for (int i = 0; i < 8; i++)
+        {
+            trace.push_back(scanBlock++);
+        }
+    }
+
+    // LRU loses the hot set to every scan, the scan blocks aren't admitted to the TinyLFU main region
+    size_t lruHits = traceHits(LRU, trace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t tinyLfuHits = traceHits(TINYLFU, trace, 8, "/tmp/trace_test.txt", blockSize);
+
+    if (lruHits == 0 && tinyLfuHits >= 4*20)
+    {
+        std::cout << "TinyLFU Scan Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "TinyLFU Scan Check Failed!\n";
+    }
+}
+
+void tinyLfuResetTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<400*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    // a hot set that fills the main region, then a scan. The frequency sketch of an 8 blocks cache halves its
+    // counters after 80 accesses, in the middle of the scan, and the hot blocks must keep their counts
+    std::vector<int> trace;
+    for (int round = 0; round < 11; round++)
+    {
+        for (int block = 0; block < 7; block++)
+        {
+            trace.push_back(block);
+        }
+    }
+    for (int block = 100; block < 108; block++)
+    {
+        trace.push_back(block);
+    }
+    size_t scanHits = traceHits(TINYLFU, trace, 8, "/tmp/trace_test.txt", blockSize);
+
+    // the hot set survives the scan
+    for (int block = 0; block < 7; block++)
+    {
+        trace.push_back(block);
+    }
+    size_t hits = traceHits(TINYLFU, trace, 8, "/tmp/trace_test.txt", blockSize);
+
+    if (hits - scanHits == 7)
+    {
+        std::cout << "TinyLFU Reset Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "TinyLFU Reset Check Failed!\n";
+    }
+}
+
+void tinyLfuClosedFileTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile1 ("/tmp/history1.txt");
+    std::ofstream outfile2 ("/tmp/history2.txt");
+    for (unsigned int i=0; i<200*blockSize; i++)
+    {
+        outfile1 << '1';
+        outfile2 << '2';
+    }
+    outfile1.close();
+    outfile2.close();
+
+    // a working set that doesn't fit in the protected list, then a scan of blocks the closed file read often.
+    // The second file gets the file descriptor of the first one, the scan must not get the closed file's
+    // estimates and push out the working set
+    char data;
+    size_t workingSetHits[2];
+    for (int run = 0; run < 2; run++)
+    {
+        CacheFS_init(32, TINYLFU, 0.1, 0.1);
+        if (run == 1)
+        {
+            int fd1 = CacheFS_open("/tmp/history1.txt");
+            for (int round = 0; round < 3; round++)
+            {
+                for (int block = 100; block < 132; block++)
+                {
+                    CacheFS_pread(fd1, &data, 1, block*blockSize);
+                }
+            }
+            CacheFS_close(fd1);
+        }
+
+        int fd2 = CacheFS_open("/tmp/history2.txt");
+        for (int round = 0; round < 3; round++)
+        {
+            for (int block = 0; block < 30; block++)
+            {
+                CacheFS_pread(fd2, &data, 1, block*blockSize);
+            }
+        }
+        for (int block = 100; block < 132; block++)
+        {
+            CacheFS_pread(fd2, &data, 1, block*blockSize);
+        }
+
+        size_t hits[2];
+        for (int i = 0; i < 2; i++)
+        {
+            if (i == 1)
+            {
+                for (int block = 0; block < 30; block++)
+                {
+                    CacheFS_pread(fd2, &data, 1, block*blockSize);
+                }
+            }
+            std::ofstream eraser;
+            eraser.open("/tmp/trace_stats.txt", std::ofstream::out | std::ofstream::trunc);
+            eraser.close();
+            CacheFS_print_stat("/tmp/trace_stats.txt");
+            std::ifstream resultsFileInput("/tmp/trace_stats.txt");
+            std::string word;
+            resultsFileInput >> word >> word >> hits[i];
+        }
+        workingSetHits[run] = hits[1] - hits[0];
+
+        CacheFS_close(fd2);
+        CacheFS_destroy();
+    }
+
+    if (workingSetHits[1] == workingSetHits[0])
+    {
+        std::cout << "TinyLFU Closed File Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "TinyLFU Closed File Check Failed!\n";
+    }
+}
+
+/**
+ * Builds a trace of Zipf distributed accesses to popular blocks mixed with blocks that are read once
+ * @param length the number of accesses
+ * @param popular the number of popular blocks, the i-th most popular block is read with weight 1/(i+1)^alpha
+ * @param alpha the Zipf skew
+ * @param noisePercent the percentage of accesses to blocks that are read once, numbered from 2*popular
+ * @param phases the number of times the popular blocks change, each phase moves them by popular blocks
+ * @param maxBlock set to the highest block number in the trace
+ */
+std::vector<int> zipfTrace(int length, int popular, double alpha, int noisePercent, int phases, int& maxBlock)
+{
+    std::vector<double> weights(popular);
+    double total = 0;
+    for (int i = 0; i < popular; i++)
+    {
+        total += 1.0/std::pow(i + 1, alpha);
+        weights[i] = total;
+    }
+
+    // a fixed linear congruential generator, so the trace is the same on every run
+    uint64_t state = 12345;
+    auto random = [&state]() {
+        state = state*6364136223846793005ULL + 1442695040888963407ULL;
+        return (double)(state >> 11)/(double)(1ULL << 53);
+    };
+
+    std::vector<int> trace;
+    int oneHitBlock = 2*popular;
+    for (int i = 0; i < length; i++)
+    {
+        if (random()*100 < noisePercent)
+        {
+            trace.push_back(oneHitBlock++);
+            continue;
+        }
+        double point = random()*total;
+        int rank = 0;
+        while (weights[rank] < point)
+        {
+            rank++;
+        }
+        int phase = i/(length/(phases + 1));
+        trace.push_back(rank + (phase%2)*popular);
+    }
+    maxBlock = oneHitBlock;
+    return trace;
+}
+
+void s3FifoHitRatioTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    // skewed accesses to 100 popular blocks, with 30% of the accesses to blocks that are read once
+    int maxBlock, shiftMaxBlock;
+    std::vector<int> zipf = zipfTrace(3000, 100, 0.8, 30, 0, maxBlock);
+    // the same, but the popular blocks change 4 times
+    std::vector<int> shiftZipf = zipfTrace(4000, 100, 0.9, 30, 4, shiftMaxBlock);
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<(std::max(maxBlock, shiftMaxBlock) + 1)*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    bool passed = true;
+    const char* names[] = {"zipf", "shifting zipf"};
+    const std::vector<int>* traces[] = {&zipf, &shiftZipf};
+    for (int i = 0; i < 2; i++)
+    {
+        size_t lruHits = traceHits(LRU, *traces[i], 10, "/tmp/trace_test.txt", blockSize);
+        size_t lfuHits = traceHits(LFU, *traces[i], 10, "/tmp/trace_test.txt", blockSize);
+        size_t fbrHits = traceHits(FBR, *traces[i], 10, "/tmp/trace_test.txt", blockSize);
+        size_t s3FifoHits = traceHits(S3FIFO, *traces[i], 10, "/tmp/trace_test.txt", blockSize);
+        std::cout << "S3-FIFO hits on the " << names[i] << " trace of " << traces[i]->size() << " accesses: LRU "
+                  << lruHits << ", LFU " << lfuHits << ", FBR " << fbrHits << ", S3-FIFO " << s3FifoHits << "\n";
+
+        // the blocks that are read once leave the small queue without pushing out the popular blocks,
+        // LFU keeps the popular blocks too, so it's closer
+        if (lruHits == 0 || lfuHits == 0 || fbrHits == 0 || s3FifoHits*100 < lruHits*120 ||
+            s3FifoHits*100 < fbrHits*120 || s3FifoHits*100 < lfuHits*103)
+        {
+            passed = false;
+        }
+    }
+
+    if (passed)
+    {
+        std::cout << "S3-FIFO Hit Ratio Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "S3-FIFO Hit Ratio Check Failed!\n";
+    }
+}
+
+void gdsfFrequencyTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<400*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    // a popular set, with a scan after every pass over it
+    std::vector<int> trace;
+    int scanBlock = 100;
+    for (int round = 0; round < 5; round++)
+    {
+        for (int block = 0; block < 4; block++)
+        {
+            trace.push_back(block);
+        }
+    }
+    for (int round = 0; round < 30; round++)
+    {
+        for (int block = 0; block < 4; block++)
+        {
+            trace.push_back(block);
+        }
+        for (int i = 0; i < 6; i++)
+        {
+            trace.push_back(scanBlock++);
+        }
+    }
+
+    // all the blocks belong to one file, so their costs are close and the reference counts decide
+    size_t lruHits = traceHits(LRU, trace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t gdsfHits = traceHits(GDSF, trace, 8, "/tmp/trace_test.txt", blockSize);
+
+    if (gdsfHits > lruHits)
+    {
+        std::cout << "GDSF Frequency Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "GDSF Frequency Check Failed!\n";
+    }
+}
+
+void sampledEvictionTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<400*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    // a working set that fits in the cache, after a scan that filled it
+    std::vector<int> fitTrace;
+    for (int block = 100; block < 108; block++)
+    {
+        fitTrace.push_back(block);
+    }
+    for (int round = 0; round < 20; round++)
+    {
+        for (int block = 0; block < 6; block++)
+        {
+            fitTrace.push_back(block);
+        }
+    }
+
+    // a popular set, with a scan after every pass over it
+    std::vector<int> scanTrace;
+    int scanBlock = 100;
+    for (int round = 0; round < 30; round++)
+    {
+        for (int block = 0; block < 4; block++)
+        {
+            scanTrace.push_back(block);
+        }
+        for (int i = 0; i < 6; i++)
+        {
+            scanTrace.push_back(scanBlock++);
+        }
+    }
+
+    // the working set only misses once, since the scan blocks are older or less used than all of its blocks
+    size_t fitMisses = 8 + 6;
+    size_t lruFitHits = traceHits(SAMPLED_LRU, fitTrace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t lfuFitHits = traceHits(SAMPLED_LFU, fitTrace, 8, "/tmp/trace_test.txt", blockSize);
+
+    // the popular blocks are used more than the scan blocks
+    size_t lruScanHits = traceHits(LRU, scanTrace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t lfuScanHits = traceHits(SAMPLED_LFU, scanTrace, 8, "/tmp/trace_test.txt", blockSize);
+
+    if (lruFitHits == fitTrace.size() - fitMisses && lfuFitHits == fitTrace.size() - fitMisses &&
+        lfuScanHits > lruScanHits)
+    {
+        std::cout << "Sampled Eviction Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "Sampled Eviction Check Failed!\n";
+    }
+}
+
+void lfuAgingTest()
+{
+    struct stat fi;
+    stat("/tmp", &fi);
+    size_t blockSize = (size_t)fi.st_blksize;
+
+    std::ofstream outfile ("/tmp/trace_test.txt");
+    for (unsigned int i=0; i<400*blockSize; i++)
+    {
+        outfile << "T";
+    }
+    outfile.close();
+
+    // a set that was popular for a while, and then a new working set that fills the cache
+    std::vector<int> oldTrace;
+    for (int round = 0; round < 40; round++)
+    {
+        for (int block = 0; block < 4; block++)
+        {
+            oldTrace.push_back(block);
+        }
+    }
+    std::vector<int> trace = oldTrace;
+    size_t newAccesses = 0;
+    for (int round = 0; round < 200; round++)
+    {
+        for (int block = 10; block < 16; block++)
+        {
+            trace.push_back(block);
+            newAccesses++;
+        }
+    }
+
+    // without aging the old blocks keep 4 of the 8 blocks and the new working set misses all the time
+    size_t oldHits = traceHits(LFU, oldTrace, 8, "/tmp/trace_test.txt", blockSize);
+    size_t hits = traceHits(LFU, trace, 8, "/tmp/trace_test.txt", blockSize);
+
+    if (hits - oldHits > newAccesses/2)
+    {
+        std::cout << "LFU Aging Check Passed!\n";
+    }
+    else
+    {
+        std::cout << "LFU Aging Check Failed!\n";
+    }
+}
+
 void pathTest()
 {
 	bool ok = true;
@@ -804,6 +2236,27 @@ int main()
     basicFBR();
     readSeveralBlocksAtOnce();
     stressTest();
+    multiThreadRead();
+    clockProThreadTest();
+    clockProHotHitsTest();
+    readaheadTest();
+    prefetchTest();
+    prefetchEvictionTest();
+    pinnedReadTest();
+    vectoredReadTest();
+    batchReadTest();
+    fileIdentityTest();
+    closedFileHistoryTest();
+    farBlockTest();
+    arcHitRatioTest();
+    lirsLoopTest();
+    tinyLfuScanTest();
+    tinyLfuResetTest();
+    tinyLfuClosedFileTest();
+    s3FifoHitRatioTest();
+    gdsfFrequencyTest();
+    sampledEvictionTest();
+    lfuAgingTest();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "TinyLFUPolicy.h"
+#include <algorithm>
+#include <new>
+
+/**
+ * Constructor
+ * @param pool the cache block pool
+ */
+TinyLFUPolicy::TinyLFUPolicy(Block* pool) : CachePolicy(pool), _window_capacity(0), _main_capacity(0),
+											_protected_capacity(0)
+{
+	_window.init(pool, LIST_WINDOW);
+	_probation.init(pool, LIST_PROBATION);
+	_protected.init(pool, LIST_PROTECTED);
+}
+
+/**
+ * Splits the cache between the window and the main region, 80% of the main region is protected,
+ * and allocates the frequency sketch
+ * @param config the algorithm parameters
+ * @return 0 if successful, otherwise -1.
+ */
+int TinyLFUPolicy::init(const PolicyConfig& config)
+{
+	_window.init(_pool, LIST_WINDOW);
+	_probation.init(_pool, LIST_PROBATION);
+	_protected.init(_pool, LIST_PROTECTED);
+	_window_capacity = std::max(config.capacity/100, 1);
+	_main_capacity = std::max(config.capacity - _window_capacity, 0);
+	_protected_capacity = _main_capacity*4/5;
+	_file_closes.clear();
+	return _sketch.init(config.capacity);
+}
+
+/**
+ * Appends the protected blocks, the window blocks and then the probation blocks, each list from its end
+ * @param ids the vector to append the ids to
+ */
+void TinyLFUPolicy::order(std::vector<int>& ids) const
+{
+	for (int id = _protected.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+	for (int id = _window.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+	for (int id = _probation.tail(); id != -1; id = _pool[id].prev)
+		ids.push_back(id);
+}
+
+/**
+ * Counts the close of a file, the sketch keys of the blocks of the next file with the same descriptor change,
+ * so they don't get the estimates of the closed file blocks
+ * When the counts can't grow the estimates are kept, they fade out with the next halvings anyway
+ * @param file_id the closed file
+ */
+void TinyLFUPolicy::forget(int file_id)
+{
+	if (file_id < 0)
+		return;
+	if ((size_t)file_id >= _file_closes.size())
+	{
+		try
+		{
+			_file_closes.resize((size_t)file_id + 1, 0);
+		} catch (std::bad_alloc& e)
+		{
+			return;
+		}
+	}
+	_file_closes[file_id]++;
+}
+
+/**
+ * Counts the access and adds the new block to the end of the window, while the window is too big
+ * and the main region has room (its victim was evicted), the window head moves to the probation list
+ * @param block the new block
+ */
+void TinyLFUPolicy::insert(Block& block)
+{
+	_sketch.increment(sketch_key(block));
+	_window.push_back(block);
+	while (_window.size() > _window_capacity && _probation.size() + _protected.size() < _main_capacity)
+	{
+		Block& candidate = _pool[_window.head()];
+		_window.remove(candidate);
+		_probation.push_back(candidate);
+	}
+}
+
+/**
+ * Chooses between the window candidate, the least recently used block of the window, and the main region victim,
+ * the least recently used block of the probation list or of the protected list if the probation list is empty
+ * The victim is evicted only if the candidate's estimated frequency is higher, so the candidate takes its place
+ * When the window isn't full yet the main region victim is evicted
+ * @return the id of the block to remove, -1 if all the blocks are pinned
+ */
+int TinyLFUPolicy::victim() const
+{
+	int candidate = first_unpinned(_window);
+	int main_victim = first_unpinned(_probation);
+	if (main_victim == -1)
+		main_victim = first_unpinned(_protected);
+
+	if (candidate == -1 || _window.size() < _window_capacity)
+		return main_victim != -1 ? main_victim : candidate;
+	if (main_victim == -1)
+		return candidate;
+
+	const Block& candidate_block = _pool[candidate];
+	const Block& victim_block = _pool[main_victim];
+	if (_sketch.frequency(sketch_key(candidate_block)) > _sketch.frequency(sketch_key(victim_block)))
+		return main_victim;
+	return candidate;
+}
+
+/**
+ * Returns the first block of a list that isn't pinned
+ * @param list the list
+ * @return the block id, -1 if all the list blocks are pinned
+ */
+int TinyLFUPolicy::first_unpinned(const BlockList& list) const
+{
+	int id = list.head();
+	while (id != -1 && _pool[id].pin_count > 0)
+		id = _pool[id].next;
+	return id;
+}
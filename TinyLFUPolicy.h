@@ -0,0 +1,137 @@
+#ifndef CACHEFS_TINYLFUPOLICY_H
+#define CACHEFS_TINYLFUPOLICY_H
+
+#include <stdint.h>
+#include <vector>
+#include "BlockList.h"
+#include "CachePolicy.h"
+#include "FrequencySketch.h"
+
+/**
+ * Window TinyLFU. New blocks enter a small LRU window, 1% of the cache (at least one block),
+ * and the rest of the cache is the main region, a segmented LRU of a probation and a protected list.
+ * A block that leaves the full window is a candidate for the main region, it takes the place of the main region
+ * victim only if a frequency sketch estimates it was accessed more often recently, otherwise the candidate is evicted.
+ * So blocks that are read once by a scan pass through the window without pushing out the working set.
+ * The sketch can't drop the keys of a closed file, so the sketch key of a block includes the number of times its
+ * file descriptor was closed, and a file that reuses the descriptor starts with fresh estimates.
+ */
+class TinyLFUPolicy final : public CachePolicy {
+public:
+	/**
+	 * Constructor
+	 * @param pool the cache block pool
+	 */
+	explicit TinyLFUPolicy(Block* pool);
+
+	int init(const PolicyConfig& config) override;
+	void order(std::vector<int>& ids) const override;
+	void forget(int file_id) override;
+
+	/**
+	 * Adds a new block to the window, the block that overflows the window moves to the main region if it has room
+	 */
+	void insert(Block& block);
+
+	/**
+	 * Counts the access and moves the block to the end of its list, a probation block moves to the protected list
+	 */
+	void access(Block& block)
+	{
+		_sketch.increment(sketch_key(block));
+		if (_window.contains(block))
+		{
+			_window.remove(block);
+			_window.push_back(block);
+		}
+		else if (_probation.contains(block))
+		{
+			_probation.remove(block);
+			_protected.push_back(block);
+			if (_protected.size() > _protected_capacity)
+			{
+				Block& demoted = _pool[_protected.head()];
+				_protected.remove(demoted);
+				_probation.push_back(demoted);
+			}
+		}
+		else
+		{
+			_protected.remove(block);
+			_protected.push_back(block);
+		}
+	}
+
+	/**
+	 * Returns the main region victim if the window candidate is estimated to be accessed more often,
+	 * otherwise the candidate, pinned blocks are skipped, -1 if all the blocks are pinned
+	 */
+	int victim() const;
+
+	/**
+	 * Removes the block from its list
+	 */
+	void remove(Block& block)
+	{
+		if (_window.contains(block))
+			_window.remove(block);
+		else if (_probation.contains(block))
+			_probation.remove(block);
+		else
+			_protected.remove(block);
+	}
+
+private:
+	/**
+	 * The list ids
+	 */
+	enum ListId {
+		LIST_WINDOW = 1,
+		LIST_PROBATION = 2,
+		LIST_PROTECTED = 3
+	};
+
+	/**
+	 * The window, and the main region lists, each ordered from the least recently used block
+	 */
+	BlockList _window;
+	BlockList _probation;
+	BlockList _protected;
+
+	/**
+	 * The max number of blocks in the window, in the main region and in the protected list
+	 */
+	int _window_capacity;
+	int _main_capacity;
+	int _protected_capacity;
+
+	/**
+	 * The recent accesses of the cached and the missing blocks
+	 */
+	FrequencySketch _sketch;
+
+	/**
+	 * The number of times each file descriptor was closed, indexed by file descriptor,
+	 * descriptors that were never closed aren't in it
+	 */
+	std::vector<uint32_t> _file_closes;
+
+	/**
+	 * Returns the key of a block in the sketch, the block key mixed with the number of times its file was closed
+	 */
+	uint64_t sketch_key(const Block& block) const
+	{
+		uint64_t key = ((uint64_t)(uint32_t)block.file_id << 32) | (uint32_t)block.block_num;
+		if ((size_t)block.file_id < _file_closes.size())
+			key ^= (uint64_t)_file_closes[block.file_id]*0x9E3779B97F4A7C15ULL;
+		return key;
+	}
+
+	/**
+	 * Returns the first block of a list that isn't pinned, -1 if there isn't one
+	 * @param list the list
+	 */
+	int first_unpinned(const BlockList& list) const;
+};
+
+#endif //CACHEFS_TINYLFUPOLICY_H